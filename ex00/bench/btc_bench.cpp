@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "csvLoader.hpp"
+#include "dictionary.hpp"
+#include "RateIndex.class.hpp"
+#include "snapshot.hpp"
+
+// Measures one generated data set: database load time, lookups per second
+// on each lookup path, and end-to-end lines per second and peak RSS of btc
+// runs over the infile.
+// Usage: btc_bench <btc> <dir with data.csv> <infile> <lookups> <threads>
+
+// --- helper functions declaration ---
+static void		benchLoad(const std::string& csv, RateIndex& index);
+static void		benchLookups(RateIndex& index, size_t count);
+static double	timeLookups(const RateIndex& index, const std::vector<int>& days,
+					bool cursor);
+static void		benchRun(const char* btc, const char* dir, const char* infile,
+					size_t lines, const char* label, const char* option,
+					const char* option_arg);
+static size_t	countLines(const char* path);
+static double	perSecond(double count, double seconds);
+
+// lookup results land here so the timed loops are not optimised away
+static volatile long	g_sink;
+
+// --- main function ---
+int	main(int ac, char** av)
+{
+	if (ac != 6)
+	{
+		std::cerr << "usage: btc_bench <btc> <dir> <infile> <lookups> <threads>"
+			<< std::endl;
+		return (NOK);
+	}
+
+	const char*	btc = av[1];
+	const char*	dir = av[2];
+	const char*	infile = av[3];
+	size_t		lookups = std::strtoul(av[4], NULL, 10);
+	const char*	threads = av[5];
+	RateIndex	index;
+
+	benchLoad(std::string(dir) + "/data.csv", index);
+	if (index.empty())
+		return (NOK);
+	benchLookups(index, lookups);
+
+	size_t	lines = countLines(infile);
+	std::cout << "end to end (" << lines << " lines):" << std::endl;
+	benchRun(btc, dir, infile, lines, "sorted index", NULL, NULL);
+	benchRun(btc, dir, infile, lines, "dense table", "--dense", NULL);
+	benchRun(btc, dir, infile, lines, "threads", "--threads", threads);
+	benchRun(btc, dir, infile, lines, "legacy reader", "--legacy-reader", NULL);
+	return (OK);
+}
+
+
+
+
+
+// --- helper functions definition ---
+static void	benchLoad(const std::string& csv, RateIndex& index)
+{
+	LoadReport	report;
+
+	std::memset(&report, 0, sizeof(report));
+	if (!loadDatabaseFile(csv.c_str(), false, index, report))
+	{
+		std::cerr << "could not load " << csv << std::endl;
+		return ;
+	}
+	std::cout << "load:   " << report.rows << " rows, " << report.bytes
+		<< " bytes in " << report.seconds * 1000.0 << " ms ("
+		<< rowsPerSecond(report) << " rows/s), index "
+		<< index.memoryUsage() << " bytes" << std::endl;
+}
+
+// random days around the history, then the same days sorted
+static void	benchLookups(RateIndex& index, size_t count)
+{
+	int					first = index.dateAt(0) - 30;
+	int					span = index.dateAt(index.size() - 1) + 30 - first;
+	std::vector<int>	days(count);
+
+	std::srand(42);
+	for (size_t i = 0; i < count; i++)
+		days[i] = first + std::rand() % span;
+
+	std::cout << "lookups (" << count << "):" << std::endl;
+	std::cout << "  binary search, random: "
+		<< perSecond(count, timeLookups(index, days, false)) << " /s" << std::endl;
+	std::vector<int>	sorted(days);
+	std::sort(sorted.begin(), sorted.end());
+	std::cout << "  merge walk, sorted:    "
+		<< perSecond(count, timeLookups(index, sorted, true)) << " /s" << std::endl;
+	if (index.buildDenseTable(DENSE_BUDGET_DEFAULT))
+		std::cout << "  dense table, random:   "
+			<< perSecond(count, timeLookups(index, days, false)) << " /s"
+			<< std::endl;
+}
+
+static double	timeLookups(const RateIndex& index, const std::vector<int>& days,
+					bool cursor)
+{
+	RateIndex::Cursor	walk;
+	long				sum = 0;
+	double				start = monotonicSeconds();
+
+	for (size_t i = 0; i < days.size(); i++)
+		sum += cursor ? index.lookup(days[i], walk) : index.lookup(days[i]);
+
+	double	seconds = monotonicSeconds() - start;
+	g_sink = sum;
+	return (seconds);
+}
+
+// runs btc in dir (it reads ./data.csv) with its output discarded
+static void	benchRun(const char* btc, const char* dir, const char* infile,
+				size_t lines, const char* label, const char* option,
+				const char* option_arg)
+{
+	double	start = monotonicSeconds();
+	pid_t	pid = fork();
+
+	if (pid == 0)
+	{
+		int	null_fd = open("/dev/null", O_WRONLY);
+
+		if (null_fd < 0 || chdir(dir) != 0)
+			_exit(NOK);
+		dup2(null_fd, STDOUT_FILENO);
+		dup2(null_fd, STDERR_FILENO);
+		if (option_arg)
+			execl(btc, btc, "--no-snapshot", option, option_arg, infile,
+				static_cast<char*>(NULL));
+		else if (option)
+			execl(btc, btc, "--no-snapshot", option, infile,
+				static_cast<char*>(NULL));
+		else
+			execl(btc, btc, "--no-snapshot", infile, static_cast<char*>(NULL));
+		_exit(NOK);
+	}
+
+	int				status = 0;
+	struct rusage	usage;
+
+	std::memset(&usage, 0, sizeof(usage));
+	if (pid < 0 || wait4(pid, &status, 0, &usage) < 0)
+		return ;
+	double	seconds = monotonicSeconds() - start;
+
+	std::cout << "  " << label << (option_arg ? " " : "")
+		<< (option_arg ? option_arg : "") << ": " << seconds * 1000.0
+		<< " ms, " << perSecond(lines, seconds) << " lines/s, peak RSS "
+		<< usage.ru_maxrss << " KiB"
+		<< (WIFEXITED(status) && WEXITSTATUS(status) == OK ? "" : " (FAILED)")
+		<< std::endl;
+}
+
+// infile lines, header excluded
+static size_t	countLines(const char* path)
+{
+	int		fd = open(path, O_RDONLY);
+	char	buf[READ_CHUNK / 16];
+	size_t	lines = 0;
+	ssize_t	len;
+
+	if (fd < 0)
+		return (0);
+	while ((len = read(fd, buf, sizeof(buf))) > 0)
+	{
+		for (ssize_t i = 0; i < len; i++)
+			lines += (buf[i] == '\n');
+	}
+	close(fd);
+	return (lines > 0 ? lines - 1 : 0);
+}
+
+static double	perSecond(double count, double seconds)
+{
+	return (seconds > 0.0 ? count / seconds : 0.0);
+}
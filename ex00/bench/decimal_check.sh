@@ -0,0 +1,20 @@
+#!/bin/sh
+# Runs btc on bench/decimal_edges.txt, values at the edges of the 10^-8
+# fixed-point resolution and of the value range, and compares its CSV
+# output (results, then rejections) with bench/decimal_edges.expected.
+# Usage: bench/decimal_check.sh
+
+BENCH=`dirname "$0"`
+OUT=${TMPDIR:-/tmp}/btc_decimal_check.txt
+
+./btc --format csv "$BENCH/decimal_edges.txt" > "$OUT" 2> "$OUT.err"
+cat "$OUT.err" >> "$OUT"
+if diff "$BENCH/decimal_edges.expected" "$OUT"; then
+	echo "decimal check: ok"
+	status=0
+else
+	echo "decimal check: FAILED"
+	status=1
+fi
+rm -f "$OUT" "$OUT.err"
+exit $status
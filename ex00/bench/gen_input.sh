@@ -0,0 +1,35 @@
+#!/bin/sh
+# Writes a synthetic "date | value" infile. <errors> percent of the lines
+# (default 4) are bad, split evenly between negative values, missing
+# values, bad dates and values too large. <order> is "random" (default),
+# "sorted" (ascending dates) or "runs" (sorted runs of ~1000 lines).
+# Usage: bench/gen_input.sh <lines> <outfile> [errors] [order]
+
+awk -v n="$1" -v errors="${3:-4}" -v order="${4:-random}" 'BEGIN {
+	srand(42);
+	print "date | value";
+	# 13 years of 12 months of 28 days from 2010-01-01, so every date exists
+	slots = 13 * 12 * 28;
+	for (i = 0; i < n; i++)
+	{
+		if (order == "sorted")
+			k = int(i * slots / n);
+		else if (order == "runs" && i % 1000 != 0)
+			k += (rand() < 0.3 && k < slots - 1);
+		else
+			k = int(rand() * slots);
+		y = 2010 + int(k / 336); m = 1 + int(k % 336 / 28); d = 1 + k % 28;
+
+		r = rand() * 100;
+		if (r < errors / 4)
+			printf("%04d-%02d-%02d | %d\n", y, m, d, -1 - int(rand() * 100));
+		else if (r < errors / 2)
+			printf("%04d-%02d-%02d\n", y, m, d);
+		else if (r < errors * 3 / 4)
+			printf("%04d-%02d-%02d | %.2f\n", y, 13, d, rand() * 1000);
+		else if (r < errors)
+			printf("%04d-%02d-%02d | %d\n", y, m, d, 1001 + int(rand() * 1000));
+		else
+			printf("%04d-%02d-%02d | %.2f\n", y, m, d, rand() * 1000);
+	}
+}' > "$2"
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Writes a synthetic "date,exchange_rate" history: a random walk between
+# 0.01 and 100000 starting on 2009-01-02, each row 1 to <max_gap> days
+# after the previous one (1 gives a row every day, larger gaps a sparser
+# history). The rows set how far it runs: bench/suite.sh picks them to
+# end with the input's dates.
+# Usage: bench/gen_rates.sh <rows> <max_gap> <outfile>
+
+awk -v n="$1" -v gap="${2:-1}" 'BEGIN {
+	srand(7);
+	print "date,exchange_rate";
+	day = 14246;
+	rate = 0.1;
+	for (i = 0; i < n; i++)
+	{
+		# civil date from days since 1970-01-01
+		z = day + 719468;
+		era = int(z / 146097);
+		doe = z - era * 146097;
+		yoe = int((doe - int(doe / 1460) + int(doe / 36524) - int(doe / 146096)) / 365);
+		doy = doe - (365 * yoe + int(yoe / 4) - int(yoe / 100));
+		mp = int((5 * doy + 2) / 153);
+		d = doy - int((153 * mp + 2) / 5) + 1;
+		m = mp < 10 ? mp + 3 : mp - 9;
+		y = yoe + era * 400 + (m <= 2);
+		printf("%04d-%02d-%02d,%.4f\n", y, m, d, rate);
+
+		rate *= 0.97 + rand() * 0.06;
+		if (rate < 0.01)
+			rate = 0.01;
+		else if (rate > 100000)
+			rate = 100000;
+		day += 1 + int(rand() * gap);
+	}
+}' > "$3"
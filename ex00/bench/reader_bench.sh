@@ -0,0 +1,29 @@
+#!/bin/sh
+# Compares the chunked infile reader with the legacy getline reader on a
+# generated input. Usage: bench/reader_bench.sh [lines]
+
+LINES=${1:-2000000}
+INPUT=${TMPDIR:-/tmp}/btc_bench_input.txt
+
+sh `dirname "$0"`/gen_input.sh "$LINES" "$INPUT"
+
+now() { date +%s.%N; }
+
+run() {
+	start=`now`
+	./btc --no-snapshot "$@" "$INPUT" > /dev/null 2>&1
+	end=`now`
+	awk -v a="$start" -v b="$end" 'BEGIN { printf("%.3f", b - a) }'
+}
+
+calc() { awk "BEGIN { printf(\"%.2f\", $1) }"; }
+
+legacy=`run --legacy-reader`
+chunked=`run`
+
+echo "lines:   $LINES"
+echo "legacy:  ${legacy}s (`calc "$LINES / $legacy"` lines/s)"
+echo "chunked: ${chunked}s (`calc "$LINES / $chunked"` lines/s)"
+echo "speedup: `calc "$legacy / $chunked"`x"
+
+rm -f "$INPUT"
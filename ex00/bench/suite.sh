@@ -0,0 +1,33 @@
+#!/bin/sh
+# Generates a rate history and an infile, then runs bench/btc_bench on
+# them: load time, lookups per second, and lines per second and peak RSS
+# of btc end to end. With rates "auto" (the default) the history holds as
+# many rows as it takes to reach the last date gen_input.sh writes, so it
+# covers the input's years and no more.
+# Usage: bench/suite.sh [rates] [max_gap] [lines] [errors] [order] [threads] [lookups]
+
+RATES=${1:-auto}
+GAP=${2:-1}
+LINES=${3:-2000000}
+ERRORS=${4:-4}
+ORDER=${5:-random}
+THREADS=${6:-4}
+LOOKUPS=${7:-10000000}
+DIR=${TMPDIR:-/tmp}/btc_suite
+BENCH=`dirname "$0"`
+
+# gen_rates.sh starts on 2009-01-02 (day 14246) and its gaps average
+# (max_gap + 1) / 2 days; gen_input.sh stops at 2022-12-28 (day 19354)
+if [ "$RATES" = auto ]; then
+	RATES=`awk -v gap="$GAP" 'BEGIN { print int((19354 - 14246) * 2 / (gap + 1)) + 1 }'`
+fi
+
+mkdir -p "$DIR"
+sh "$BENCH"/gen_rates.sh "$RATES" "$GAP" "$DIR/data.csv"
+sh "$BENCH"/gen_input.sh "$LINES" "$DIR/input.txt" "$ERRORS" "$ORDER"
+
+LAST=`tail -n 1 "$DIR/data.csv" | cut -d, -f1`
+echo "rates: $RATES (max gap $GAP days, 2009-01-02 .. $LAST), lines: $LINES ($ERRORS% bad, $ORDER order)"
+"$BENCH"/btc_bench "$PWD/btc" "$DIR" "$DIR/input.txt" "$LOOKUPS" "$THREADS"
+
+rm -rf "$DIR"
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Times --threads 1..N on a generated input and checks that every run
+# prints exactly what the single-threaded reader prints.
+# Usage: bench/threads_bench.sh [lines] [max_threads]
+
+LINES=${1:-2000000}
+MAX=${2:-`nproc 2>/dev/null || echo 4`}
+DIR=${TMPDIR:-/tmp}
+INPUT=$DIR/btc_bench_input.txt
+
+sh `dirname "$0"`/gen_input.sh "$LINES" "$INPUT"
+
+now() { date +%s.%N; }
+calc() { awk "BEGIN { printf(\"%.2f\", $1) }"; }
+
+./btc --no-snapshot "$INPUT" > "$DIR/btc_ref.out" 2> "$DIR/btc_ref.err"
+
+echo "lines: $LINES"
+base=""
+t=1
+while [ "$t" -le "$MAX" ]
+do
+	start=`now`
+	./btc --no-snapshot --threads "$t" "$INPUT" > "$DIR/btc_t.out" 2> "$DIR/btc_t.err"
+	end=`now`
+	secs=`calc "$end - $start"`
+	[ -z "$base" ] && base=$secs
+	same="identical"
+	cmp -s "$DIR/btc_ref.out" "$DIR/btc_t.out" && cmp -s "$DIR/btc_ref.err" "$DIR/btc_t.err" \
+		|| same="MISMATCH"
+	echo "threads $t: ${secs}s (`calc "$LINES / $secs"` lines/s, speedup `calc "$base / $secs"`x, $same)"
+	t=`expr $t + 1`
+done
+
+rm -f "$INPUT" "$DIR"/btc_ref.out "$DIR"/btc_ref.err "$DIR"/btc_t.out "$DIR"/btc_t.err
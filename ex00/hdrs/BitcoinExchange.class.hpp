@@ -4,21 +4,49 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
-#include <map>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "colors.hpp"
+#include "csvLoader.hpp"
+#include "dates.hpp"
 #include "dictionary.hpp"
+#include "OutputBuffer.class.hpp"
+#include "RangeIndex.class.hpp"
+#include "RateIndex.class.hpp"
+#include "RateStore.class.hpp"
+#include "ResultWriter.class.hpp"
+#include "scanners.hpp"
+#include "snapshot.hpp"
+#include "WorkerPool.class.hpp"
 
 class BitcoinExchange
 {
 	public:
-		BitcoinExchange(std::ifstream& infile, std::ifstream& database);
+		BitcoinExchange(std::ifstream& infile);
 		~BitcoinExchange();
 
+		int					loadDatabase(const char* path, bool use_snapshot);
+		int					loadSeries(const std::string& symbol, const char* path,
+								bool use_snapshot);
+		int					loadSeriesTable(const char* path);
+		void				buildSymbolTable();
+		const RateStore&	store() const;
+		const LoadReport&	loadReport() const;
+		const LoadReport&	tableReport() const;
+		const LookupStats&	lookupStats() const;
+		bool	enableDenseLookup(size_t budget_bytes);
+		bool	rangeStats(const std::string& from, const std::string& to,
+					RangeResult& result) const;
+		void	setPlainOutput(bool plain);
+		void	setOutputFormat(OutputFormat format);
+		int		redirectErrors(const char* path);
 		void	readInfile();
-		void	transformLine(const std::string& infile_date, float infile_value);
+		void	readInfileParallel(size_t threads);
+		void	readInfileLegacy();
+		void	transformLine(const std::string& infile_date,
+					const std::string& infile_value);
 		void	missingHeader() const;
 		void	badLine(const std::string& input) const;
 		void	badDate(const std::string& date) const;
@@ -30,8 +58,51 @@ class BitcoinExchange
 		BitcoinExchange(const BitcoinExchange& old_obj);
 		BitcoinExchange& operator=(const BitcoinExchange& old_obj);
 
-		std::ifstream&					_infile;
-		std::map<std::string, float>	_dbData;
+		// where a reader is in the infile
+		struct ScanState
+		{
+			ScanState();
+
+			bool				first_line;
+			size_t				line_no;
+			RateIndex::Cursor	cursor;
+		};
+
+		struct ChunkJob
+		{
+			ChunkJob();
+
+			const BitcoinExchange*	exchange;
+			const char*				data;
+			size_t					len;
+			ScanState				state;
+			OutputBuffer			out;
+			OutputBuffer			err;
+		};
+
+		static void	processChunk(void* arg);
+		size_t		processLines(const char* data, size_t len, bool final,
+						ScanState& state, OutputBuffer& out,
+						OutputBuffer& err) const;
+		void		convertLine(OutputBuffer& out, OutputBuffer& err,
+						ScanState& state, const InputLine& line,
+						const RateIndex& index) const;
+		void		reportRejection(LineStatus status,
+						const std::string& token) const;
+
+		std::ifstream&	_infile;
+		RateIndex		_index;
+		RangeIndex		_ranges;
+		RateStore		_store;
+		LoadReport		_loadReport;
+		LoadReport		_tableReport;
+		OutputBuffer	_out;
+		OutputBuffer	_err;
+		int				_errFd;
+		ResultWriter	_writer;
+		ScanState		_legacyState;
+		LookupStats		_lookupStats;
+		bool			_plain;
 };
 
 #endif // #ifndef BITCOINEXCHANGE_CLASS_HPP
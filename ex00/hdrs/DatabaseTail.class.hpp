@@ -0,0 +1,55 @@
+#ifndef DATABASETAIL_CLASS_HPP
+#define DATABASETAIL_CLASS_HPP
+
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+
+#include "csvLoader.hpp"
+#include "RateIndex.class.hpp"
+
+enum TailStatus
+{
+	TAIL_UNCHANGED,
+	TAIL_APPENDED,
+	TAIL_REPLACED,
+	TAIL_FAILED
+};
+
+// changed_from is the first index row the poll changed: the rows before
+// it are as they were
+struct TailReport
+{
+	size_t	rows;
+	size_t	skipped;
+	size_t	bytes;
+	size_t	added;
+	size_t	changed_from;
+};
+
+// Follows an append-only rate CSV from the byte offset an index was loaded
+// up to: poll() parses only the complete lines written since and feeds
+// them to the index. A file that shrank or was replaced (new inode) is
+// reported as TAIL_REPLACED and needs a full reload instead.
+class DatabaseTail
+{
+	public:
+		DatabaseTail();
+		~DatabaseTail();
+
+		bool		start(const char* path, size_t offset);
+		TailStatus	poll(RateIndex& index, TailReport& report);
+		size_t		offset() const;
+
+	private:
+		DatabaseTail(const DatabaseTail& old_obj);
+		DatabaseTail& operator=(const DatabaseTail& old_obj);
+
+		std::string	_path;
+		size_t		_offset;
+		dev_t		_dev;
+		ino_t		_ino;
+		bool		_started;
+};
+
+#endif // #ifndef DATABASETAIL_CLASS_HPP
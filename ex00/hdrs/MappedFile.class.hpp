@@ -0,0 +1,29 @@
+#ifndef MAPPEDFILE_CLASS_HPP
+#define MAPPEDFILE_CLASS_HPP
+
+#include <cstddef>
+
+// Read-only, private memory mapping of a whole file.
+class MappedFile
+{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		bool		open(const char* path);
+		void		close();
+
+		const char*	data() const;
+		size_t		size() const;
+		bool		isOpen() const;
+
+	private:
+		MappedFile(const MappedFile& old_obj);
+		MappedFile& operator=(const MappedFile& old_obj);
+
+		void*	_addr;
+		size_t	_size;
+		bool	_open;
+};
+
+#endif // #ifndef MAPPEDFILE_CLASS_HPP
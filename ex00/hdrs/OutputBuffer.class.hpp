@@ -0,0 +1,48 @@
+#ifndef OUTPUTBUFFER_CLASS_HPP
+#define OUTPUTBUFFER_CLASS_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "decimal.hpp"
+
+#define NO_FD -1
+#define STREAM_PRECISION 6
+
+// Append-only byte buffer. Bound to a file descriptor it is written out in
+// large blocks (or after every line when line buffered); unbound it just
+// grows and is read back with data()/size().
+class OutputBuffer
+{
+	public:
+		OutputBuffer(int fd, size_t capacity);
+		~OutputBuffer();
+
+		void		append(const char* str, size_t len);
+		void		append(const char* str);
+		void		append(char c);
+		void		appendNumber(double value, int precision = STREAM_PRECISION);
+		void		appendDecimal(Decimal value);
+		void		endLine();
+		void		flush();
+		void		clear();
+
+		void		setFd(int fd);
+		void		setLineBuffered(bool line_buffered);
+		const char*	data() const;
+		size_t		size() const;
+
+	private:
+		OutputBuffer();
+		OutputBuffer(const OutputBuffer& old_obj);
+		OutputBuffer& operator=(const OutputBuffer& old_obj);
+
+		void	reserve(size_t extra);
+
+		int					_fd;
+		std::vector<char>	_buf;
+		size_t				_len;
+		bool				_lineBuffered;
+};
+
+#endif // #ifndef OUTPUTBUFFER_CLASS_HPP
@@ -0,0 +1,129 @@
+#ifndef QUERYSERVER_CLASS_HPP
+#define QUERYSERVER_CLASS_HPP
+
+#include <cstddef>
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "csvLoader.hpp"
+#include "DatabaseTail.class.hpp"
+#include "OutputBuffer.class.hpp"
+#include "RangeIndex.class.hpp"
+#include "RateIndex.class.hpp"
+#include "ResultWriter.class.hpp"
+#include "scanners.hpp"
+
+#define SERVER_READ_CHUNK (64UL << 10)
+#define SERVER_BACKLOG 64
+#define LATENCY_WINDOW 65536
+
+// Resident mode (--serve): loads the rate index once and answers one
+// response line per request line, over stdin/stdout or a Unix socket.
+//
+//   YYYY-MM-DD | value   conversion, in the selected --format
+//   YYYY-MM-DD .. YYYY-MM-DD
+//                        rate count, min, max, mean and time-weighted mean
+//   RELOAD               reloads the database and swaps it in atomically
+//   REFRESH              applies only the rows appended to the database
+//   STATS                query count and latency percentiles
+//   QUIT                 closes the connection
+//
+// Requests may be pipelined: everything read in one go is answered in one
+// write. Every batch pins the index version it started with, so a RELOAD
+// from another client never stalls or invalidates in-flight queries. A
+// REFRESH updates the current version in place, waiting for the batches
+// reading it; its cost, range index included, depends only on the
+// appended rows (plus the rows after an out-of-order correction).
+class QueryServer
+{
+	public:
+		QueryServer(const char* db_path, bool use_snapshot, bool dense,
+			size_t dense_budget);
+		~QueryServer();
+
+		int		load();
+		void	setFormat(OutputFormat format);
+		int		serveStream(int in_fd, int out_fd);
+		int		serveSocket(const char* socket_path);
+
+		static void	requestStop();
+
+	private:
+		QueryServer();
+		QueryServer(const QueryServer& old_obj);
+		QueryServer& operator=(const QueryServer& old_obj);
+
+		// one loaded database, shared by every batch that pinned it
+		struct IndexVersion
+		{
+			IndexVersion();
+			~IndexVersion();
+
+			RateIndex			index;
+			RangeIndex			ranges;
+			LoadReport			report;
+			DatabaseTail		tail;
+			pthread_rwlock_t	lock;
+			size_t				refs;
+			unsigned long		generation;
+		};
+
+		struct Session
+		{
+			Session();
+
+			IndexVersion*			version;
+			unsigned long			generation;
+			RateIndex::Cursor		cursor;
+			size_t					requests;
+			std::vector<uint32_t>	latencies;
+		};
+
+		struct Connection
+		{
+			QueryServer*	server;
+			int				fd;
+		};
+
+		IndexVersion*	loadVersion();
+		IndexVersion*	acquire();
+		void			release(IndexVersion* version);
+		void			pin(Session& session);
+		void			unpin(Session& session);
+		bool			reload(OutputBuffer& out);
+		bool			refresh(OutputBuffer& out);
+
+		static void*	connectionMain(void* arg);
+		void			serveConnection(int in_fd, int out_fd);
+		size_t			handleBatch(const char* data, size_t len, bool final,
+							Session& session, OutputBuffer& out, bool& quit);
+		bool			handleRequest(const char* line, const char* end,
+							Session& session, OutputBuffer& out);
+		void			writeStats(OutputBuffer& out);
+		void			recordLatencies(Session& session);
+
+		std::string			_dbPath;
+		bool				_useSnapshot;
+		bool				_dense;
+		size_t				_denseBudget;
+		ResultWriter		_writer;
+
+		IndexVersion*		_current;
+		unsigned long		_generation;
+		pthread_mutex_t		_versionMutex;
+		pthread_mutex_t		_reloadMutex;
+
+		std::vector<uint32_t>	_latencies;
+		size_t					_latencyNext;
+		size_t					_queries;
+		size_t					_reloads;
+		pthread_mutex_t			_statsMutex;
+
+		std::vector<int>	_clients;
+		pthread_mutex_t		_clientsMutex;
+		pthread_cond_t		_clientsDone;
+};
+
+#endif // #ifndef QUERYSERVER_CLASS_HPP
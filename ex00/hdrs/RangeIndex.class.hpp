@@ -0,0 +1,61 @@
+#ifndef RANGEINDEX_CLASS_HPP
+#define RANGEINDEX_CLASS_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "decimal.hpp"
+#include "RateIndex.class.hpp"
+
+#define RANGE_BLOCK 32
+
+// statistics of the rates between two dates (both included)
+struct RangeResult
+{
+	size_t		count;
+	DecimalSum	sum;
+	Decimal		min;
+	Decimal		max;
+	Decimal		mean;
+	bool		timed;
+	Decimal		twap;
+};
+
+// Side structures over a finalized RateIndex for range queries:
+//   - prefix sums of the rates, so count, sum and mean are O(1);
+//   - prefix sums of rate * days it stayed in effect, so the time-weighted
+//     average over any calendar range is O(1);
+//   - a sparse table over blocks of RANGE_BLOCK rows, each entry the
+//     extremes of 2^k blocks ending at its block, so min and max scan at
+//     most two partial blocks plus two table lookups.
+// It reads the index arrays in place. After the index changes, update()
+// recomputes everything from the first changed row on; the entries of
+// earlier rows and blocks are kept, so appending rows costs only them.
+class RangeIndex
+{
+	public:
+		RangeIndex();
+		~RangeIndex();
+
+		void	build(const RateIndex& index);
+		void	update(const RateIndex& index, size_t from);
+		void	query(int from_day, int to_day, RangeResult& result) const;
+		size_t	memoryUsage() const;
+
+	private:
+		RangeIndex(const RangeIndex& old_obj);
+		RangeIndex& operator=(const RangeIndex& old_obj);
+
+		DecimalSum	timeIntegral(int day) const;
+		void		scanExtremes(size_t first, size_t last, Decimal& min,
+						Decimal& max) const;
+
+		const RateIndex*		_index;
+		std::vector<DecimalSum>	_rateSums;
+		std::vector<DecimalSum>	_timeSums;
+		std::vector<std::vector<Decimal> >	_blockMin;
+		std::vector<std::vector<Decimal> >	_blockMax;
+		size_t					_blocks;
+};
+
+#endif // #ifndef RANGEINDEX_CLASS_HPP
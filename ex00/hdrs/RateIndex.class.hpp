@@ -0,0 +1,104 @@
+#ifndef RATEINDEX_CLASS_HPP
+#define RATEINDEX_CLASS_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "decimal.hpp"
+#include "MappedFile.class.hpp"
+
+#define NO_RATE -1L
+#define MERGE_WALK_MAX 8
+#define NO_POS (~static_cast<size_t>(0))
+
+// how many lookups each path answered
+struct LookupStats
+{
+	size_t	merged;
+	size_t	searched;
+	size_t	direct;
+};
+
+void	addLookupStats(LookupStats& total, const LookupStats& part);
+
+// Flat, sorted rate history: dates are packed as days since 1970-01-01 in
+// one contiguous array and the matching rates live in a parallel array.
+// The arrays are either owned or borrowed (from a mapped snapshot or a
+// shared arena); any mutation first copies borrowed arrays into owned
+// storage.
+//
+// Rows are added with insert(). A row newer than the last date is appended
+// in place and a repeat of the last date overwrites its rate, both visible
+// to lookups at once; older rows (corrections) are queued and only show up
+// once finalize() merges them in, so its cost depends on the rows added
+// since the previous call, not on the index size. It returns the first row
+// changed since that call (NO_POS when none). Neither is safe while other
+// threads look up: callers serialize them against readers (the server
+// holds the version's write lock).
+class RateIndex
+{
+	public:
+		// per-reader position for merge-walking sorted runs of queries;
+		// index is the one it last walked, so one cursor can follow
+		// lookups that switch between indexes
+		struct Cursor
+		{
+			Cursor();
+
+			long				pos;
+			int					day;
+			const RateIndex*	index;
+			LookupStats			stats;
+		};
+
+		// a row older than the last date, waiting for finalize()
+		struct Correction
+		{
+			int		day;
+			Decimal	rate;
+		};
+
+		RateIndex();
+		~RateIndex();
+
+		void	insert(int day, Decimal rate);
+		size_t	finalize();
+		void	attach(const int* dates, const Decimal* rates, size_t count,
+					MappedFile* mapping);
+		bool	buildDenseTable(size_t budget_bytes);
+		bool	isDense() const;
+
+		long			lookup(int day) const;
+		long			lookup(int day, Cursor& cursor) const;
+		size_t			size() const;
+		bool			empty() const;
+		int				dateAt(size_t pos) const;
+		Decimal			rateAt(size_t pos) const;
+		const int*		dates() const;
+		const Decimal*	rates() const;
+		bool			isMapped() const;
+		size_t			memoryUsage() const;
+
+	private:
+		RateIndex(const RateIndex& old_obj);
+		RateIndex& operator=(const RateIndex& old_obj);
+
+		void	mergeCorrections();
+		bool	fillDenseTable(size_t from_pos);
+		void	materialize();
+		void	syncView();
+
+		std::vector<int>		_dates;
+		std::vector<Decimal>	_rates;
+		std::vector<Correction>	_corrections;
+		std::vector<int>		_dense;
+		size_t					_denseBudget;
+		size_t					_dirtyFrom;
+		const int*				_datePtr;
+		const Decimal*			_ratePtr;
+		size_t					_count;
+		MappedFile*				_mapping;
+		bool					_borrowed;
+};
+
+#endif // #ifndef RATEINDEX_CLASS_HPP
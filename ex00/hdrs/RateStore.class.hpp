@@ -0,0 +1,62 @@
+#ifndef RATESTORE_CLASS_HPP
+#define RATESTORE_CLASS_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "csvLoader.hpp"
+#include "decimal.hpp"
+#include "dictionary.hpp"
+#include "RangeIndex.class.hpp"
+#include "RateIndex.class.hpp"
+#include "scanners.hpp"
+
+#define TABLE_HEADER "symbol,date,exchange_rate"
+
+// Rate series of many assets. Series are loaded one file per symbol
+// (loadFile) or from one "symbol,date,exchange_rate" table (loadTable),
+// then seal() packs every series into one shared date/rate arena, each
+// symbol a contiguous sorted slice served by its own RateIndex, and sorts
+// the symbol table for binary-search lookups by name.
+class RateStore
+{
+	public:
+		struct Series
+		{
+			std::string	name;
+			RateIndex*	index;
+			RangeIndex*	ranges;
+			LoadReport	report;
+			bool		external;
+		};
+
+		RateStore();
+		~RateStore();
+
+		bool	loadFile(const std::string& name, const char* path,
+					bool use_snapshot);
+		bool	loadTable(const char* path, LoadReport& report);
+		bool	addExternal(const std::string& name, RateIndex& index,
+					RangeIndex& ranges);
+		void	seal();
+		void	buildDenseTables(size_t budget_bytes);
+
+		const Series*	find(const char* name, size_t len) const;
+		size_t			size() const;
+		const Series&	at(size_t pos) const;
+		size_t			memoryUsage(size_t pos) const;
+
+	private:
+		RateStore(const RateStore& old_obj);
+		RateStore& operator=(const RateStore& old_obj);
+
+		Series*	add(const std::string& name, bool external);
+
+		std::vector<Series>		_series;
+		std::vector<int>		_dates;
+		std::vector<Decimal>	_rates;
+		bool					_sealed;
+};
+
+#endif // #ifndef RATESTORE_CLASS_HPP
@@ -0,0 +1,109 @@
+#ifndef RESULTWRITER_CLASS_HPP
+#define RESULTWRITER_CLASS_HPP
+
+#include <cstddef>
+#include <stdint.h>
+
+#include "dictionary.hpp"
+#include "OutputBuffer.class.hpp"
+#include "RangeIndex.class.hpp"
+#include "RateIndex.class.hpp"
+#include "scanners.hpp"
+
+#define RECORD_MAGIC "BTCREC"
+#define RECORD_VERSION 3
+#define RECORD_NO_DATE INT32_MIN
+
+enum OutputFormat
+{
+	FORMAT_TEXT,
+	FORMAT_CSV,
+	FORMAT_NDJSON,
+	FORMAT_BINARY
+};
+
+// one converted input line; symbol_len is 0 when the line named no symbol
+// and was answered by the default database
+struct Conversion
+{
+	size_t		line;
+	const char*	symbol;
+	size_t		symbol_len;
+	const char*	date;
+	int			day;
+	Decimal		amount;
+	bool		matched;
+	int			db_day;
+	Decimal		rate;
+	Decimal		value;
+};
+
+// --format binary stream: one RecordHeader, then fixed-width records in
+// input order, host byte order, so the file can be mapped as an array.
+// Amounts, rates and values are Decimals (units of 10^-DECIMAL_DIGITS);
+// symbol is NUL-padded, without a terminator when SYMBOL_MAX long.
+struct RecordHeader
+{
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	record_size;
+};
+
+struct ConversionRecord
+{
+	int64_t		amount;
+	int64_t		rate;
+	int64_t		value;
+	int32_t		day;
+	int32_t		db_day;
+	uint32_t	line;
+	uint32_t	reserved;
+	char		symbol[SYMBOL_MAX];
+};
+
+// Formats conversions and rejected lines for the selected output format:
+// colored (or --plain) text, CSV, newline-delimited JSON or binary records.
+// Rejections are written to their own stream with line numbers in every
+// machine-readable format (NDJSON for binary output). Range query results
+// go with the conversions (CSV rows
+// "line,symbol,from,to,count,min,max,mean,twap") except in binary output,
+// where they join the rejections as NDJSON. Machine-readable records
+// always carry the symbol that answered them, DEFAULT_SYMBOL for lines
+// without one; text shows it only when the line named one.
+class ResultWriter
+{
+	public:
+		ResultWriter();
+		~ResultWriter();
+
+		void	setFormat(OutputFormat format);
+		void	setPlain(bool plain);
+
+		void	writeStreamHeader(OutputBuffer& out) const;
+		void	writeSeparator(OutputBuffer& out) const;
+		void	writeConversion(OutputBuffer& out, const Conversion& conv) const;
+		void	writeRange(OutputBuffer& out, OutputBuffer& err, size_t line,
+					const InputLine& input, const RangeResult& range) const;
+		void	writeMissingHeader(OutputBuffer& err) const;
+		void	writeRejection(OutputBuffer& err, size_t line, LineStatus status,
+					const char* token, size_t len) const;
+
+	private:
+		ResultWriter(const ResultWriter& old_obj);
+		ResultWriter& operator=(const ResultWriter& old_obj);
+
+		void	style(OutputBuffer& buf, const char* code) const;
+		void	writeTextError(OutputBuffer& err, const char* what,
+					const char* token, size_t len) const;
+		void	writeTextSymbol(OutputBuffer& out, const char* symbol,
+					size_t len) const;
+
+		OutputFormat	_format;
+		bool			_plain;
+};
+
+bool	parseOutputFormat(const char* name, OutputFormat& format);
+bool	resolveConversion(const RateIndex& index, RateIndex::Cursor& cursor,
+			size_t line_no, const InputLine& line, Conversion& conv);
+
+#endif // #ifndef RESULTWRITER_CLASS_HPP
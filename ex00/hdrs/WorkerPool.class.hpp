@@ -0,0 +1,41 @@
+#ifndef WORKERPOOL_CLASS_HPP
+#define WORKERPOOL_CLASS_HPP
+
+#include <cstddef>
+#include <pthread.h>
+#include <vector>
+
+// Fixed set of pthreads that run batches of independent tasks; run()
+// hands out the tasks and blocks until the whole batch is done.
+class WorkerPool
+{
+	public:
+		typedef void	(*Task)(void* arg);
+
+		WorkerPool(size_t threads);
+		~WorkerPool();
+
+		void	run(Task task, void** args, size_t count);
+		size_t	size() const;
+
+	private:
+		WorkerPool();
+		WorkerPool(const WorkerPool& old_obj);
+		WorkerPool& operator=(const WorkerPool& old_obj);
+
+		static void*	workerMain(void* arg);
+		void			workerLoop();
+
+		std::vector<pthread_t>	_threads;
+		pthread_mutex_t			_mutex;
+		pthread_cond_t			_wake;
+		pthread_cond_t			_done;
+		Task					_task;
+		void**					_args;
+		size_t					_count;
+		size_t					_next;
+		size_t					_pending;
+		bool					_stop;
+};
+
+#endif // #ifndef WORKERPOOL_CLASS_HPP
@@ -0,0 +1,27 @@
+#ifndef CSVLOADER_HPP
+#define CSVLOADER_HPP
+
+#include <cstddef>
+
+#include "RateIndex.class.hpp"
+
+#define DB_HEADER "date,exchange_rate"
+
+struct LoadReport
+{
+	size_t	rows;
+	size_t	skipped;
+	size_t	bytes;
+	size_t	source_size;
+	double	seconds;
+	bool	from_snapshot;
+};
+
+size_t	parseRateCsv(const char* data, size_t len, RateIndex& index,
+			LoadReport& report);
+bool	loadRateCsv(const char* path, RateIndex& index, LoadReport& report);
+bool	parseRateRow(const char* line, const char* end, int& day, Decimal& rate);
+double	rowsPerSecond(const LoadReport& report);
+double	monotonicSeconds();
+
+#endif // #ifndef CSVLOADER_HPP
@@ -0,0 +1,15 @@
+#ifndef DATES_HPP
+#define DATES_HPP
+
+#define DATE_LEN 10
+#define DATE_PREFIX_LEN 14
+
+bool	isLeapYear(int year);
+bool	dayIsInvalid(int day, int month, int year);
+bool	parseDate(const char* str, int& year, int& month, int& day);
+bool	parseDatePrefix(const char* str, int& year, int& month, int& day);
+int		daysFromCivil(int year, int month, int day);
+void	civilFromDays(int days, int& year, int& month, int& day);
+void	formatDate(int days, char* out);
+
+#endif // #ifndef DATES_HPP
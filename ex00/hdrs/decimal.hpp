@@ -0,0 +1,25 @@
+#ifndef DECIMAL_HPP
+#define DECIMAL_HPP
+
+#include <cstddef>
+#include <stdint.h>
+
+// Fixed-point decimal: an int64 count of 10^-DECIMAL_DIGITS units, so any
+// value with up to DECIMAL_DIGITS decimals is held exactly and the
+// conversion hot path stays integer-only.
+typedef int64_t	Decimal;
+
+// wide accumulator for sums of many Decimals
+__extension__ typedef __int128	DecimalSum;
+
+#define DECIMAL_DIGITS 8
+#define DECIMAL_SCALE 100000000LL
+#define DECIMAL_TEXT_MAX 32
+
+bool	scanDecimal(const char*& cur, const char* end, Decimal& value);
+bool	mulDecimal(Decimal a, Decimal b, Decimal& product);
+size_t	formatDecimal(Decimal value, char* out);
+double	decimalToDouble(Decimal value);
+Decimal	divideSum(DecimalSum sum, uint64_t count);
+
+#endif // #ifndef DECIMAL_HPP
@@ -5,4 +5,19 @@
 #define NOK 1
 #define ERROR -1
 
+#define INFILE_HEADER "date | value"
+#define INFILE_YEAR_MIN 2001
+#define INFILE_YEAR_MAX 2025
+#define INFILE_VALUE_MAX 1000
+#define INFILE_RANGE_SEP ".."
+#define SYMBOL_MAX 16
+#define DEFAULT_SYMBOL "BTC"
+
+#define READ_CHUNK (1UL << 20)
+#define PARALLEL_CHUNK (4UL << 20)
+#define THREADS_MAX 256
+#define OUTPUT_BUFFER_SIZE (1UL << 20)
+#define LINE_BUFFER_SIZE 256
+#define DENSE_BUDGET_DEFAULT (64UL * 1024 * 1024)
+
 #endif // #ifndef DICTIONARY_HPP
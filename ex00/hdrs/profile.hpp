@@ -0,0 +1,48 @@
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+#include <stdint.h>
+
+#include "scanners.hpp"
+
+#define PROFILE_BUCKETS 32
+
+// Hot-path instrumentation, compiled in with -DBTC_PROFILE (make profile):
+// nanosecond timers per phase, accepted/rejected line counters per kind
+// and a log2 histogram of lookup latency, printed to stderr on exit and
+// on SIGUSR1. Without BTC_PROFILE every macro expands to nothing.
+enum ProfilePhase
+{
+	PHASE_LOAD,
+	PHASE_PARSE,
+	PHASE_LOOKUP,
+	PHASE_FORMAT,
+	PHASE_COUNT
+};
+
+#ifdef BTC_PROFILE
+
+uint64_t	profileNow();
+void		profileAdd(ProfilePhase phase, uint64_t start);
+void		profileLookup(uint64_t start);
+void		profileLine(LineStatus status);
+void		profileInstall();
+void		profileReport();
+
+# define PROFILE_INSTALL() profileInstall()
+# define PROFILE_START(timer) uint64_t timer = profileNow()
+# define PROFILE_STOP(phase, timer) profileAdd(phase, timer)
+# define PROFILE_LOOKUP(timer) profileLookup(timer)
+# define PROFILE_LINE(status) profileLine(status)
+
+#else
+
+# define PROFILE_INSTALL() ((void)0)
+# define PROFILE_START(timer) ((void)0)
+# define PROFILE_STOP(phase, timer) ((void)0)
+# define PROFILE_LOOKUP(timer) ((void)0)
+# define PROFILE_LINE(status) ((void)0)
+
+#endif // #ifdef BTC_PROFILE
+
+#endif // #ifndef PROFILE_HPP
@@ -0,0 +1,40 @@
+#ifndef SCANNERS_HPP
+#define SCANNERS_HPP
+
+#include <cstddef>
+
+#include "decimal.hpp"
+
+enum LineStatus
+{
+	LINE_VALID,
+	LINE_RANGE,
+	LINE_BAD_LINE,
+	LINE_BAD_DATE,
+	LINE_BAD_VALUE,
+	LINE_TOO_LARGE,
+	LINE_BAD_SYMBOL
+};
+
+// one "date | value" (or "date .. date" range query) input line, maybe
+// prefixed by a symbol; token points into the scanned buffer: the date
+// when valid, the offending token (or whole line) otherwise. amount is the
+// value token of a valid line; symbol_len is 0 without a symbol.
+struct InputLine
+{
+	const char*	symbol;
+	size_t		symbol_len;
+	int			day;
+	int			to_day;
+	Decimal		value;
+	const char*	token;
+	size_t		token_len;
+	const char*	amount;
+	size_t		amount_len;
+};
+
+bool		isBlank(char c);
+bool		isSymbolName(const char* name, size_t len);
+LineStatus	scanInputLine(const char* begin, const char* end, InputLine& line);
+
+#endif // #ifndef SCANNERS_HPP
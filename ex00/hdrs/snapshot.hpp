@@ -0,0 +1,37 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <stdint.h>
+#include <string>
+
+#include "csvLoader.hpp"
+#include "RateIndex.class.hpp"
+
+#define SNAPSHOT_SUFFIX ".snap"
+#define SNAPSHOT_MAGIC "BTCSNAP"
+#define SNAPSHOT_VERSION 2
+
+// On-disk layout: this header, then count packed int64 Decimal rates, then
+// count packed int32 dates, all in host byte order (rates first so they
+// stay 8-byte aligned in the mapping).
+struct SnapshotHeader
+{
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	header_size;
+	uint64_t	csv_size;
+	int64_t		csv_mtime_sec;
+	int64_t		csv_mtime_nsec;
+	uint64_t	count;
+	uint64_t	checksum;
+};
+
+std::string	snapshotPath(const char* csv_path);
+bool		loadSnapshot(const char* csv_path, RateIndex& index,
+				size_t& csv_size);
+bool		writeSnapshot(const char* csv_path, const RateIndex& index,
+				size_t csv_size);
+bool		loadDatabaseFile(const char* csv_path, bool use_snapshot,
+				RateIndex& index, LoadReport& report);
+
+#endif // #ifndef SNAPSHOT_HPP
@@ -1,31 +1,49 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include "BitcoinExchange.class.hpp"
+#include "profile.hpp"
 
 // --- constructors / destructor ---
-BitcoinExchange::BitcoinExchange(std::ifstream& infile, std::ifstream& dbfile)
-	: _infile(infile)
+BitcoinExchange::BitcoinExchange(std::ifstream& infile)
+	: _infile(infile),
+	_out(STDOUT_FILENO, OUTPUT_BUFFER_SIZE),
+	_err(STDERR_FILENO, OUTPUT_BUFFER_SIZE),
+	_errFd(NO_FD),
+	_plain(false)
 {
-	std::string line;
-	while (std::getline(dbfile, line))
-	{
-		if (!line.compare("date,exchange_rate"))
-			continue;
+	std::memset(&_loadReport, 0, sizeof(_loadReport));
+	std::memset(&_tableReport, 0, sizeof(_tableReport));
+	std::memset(&_lookupStats, 0, sizeof(_lookupStats));
+
+	// keep stdout and stderr lines interleaved when a person is watching
+	bool	interactive = isatty(STDOUT_FILENO) || isatty(STDERR_FILENO);
+	_out.setLineBuffered(interactive);
+	_err.setLineBuffered(interactive);
+}
 
-		std::string date = line.substr(0, 10);
-		std::string value_str = line.substr(11);
+BitcoinExchange::ScanState::ScanState()
+	: first_line(true), line_no(0)
+{
 
-		if (date.empty() || value_str.empty() || line[10] != ',')
-			continue;
+}
+
+BitcoinExchange::ChunkJob::ChunkJob()
+	: exchange(NULL), data(NULL), len(0),
+	out(NO_FD, PARALLEL_CHUNK * 2), err(NO_FD, PARALLEL_CHUNK / 4)
+{
 
-		std::istringstream iss(value_str);
-		float value_float;
-		if (iss >> value_float)
-			_dbData[date] = value_float;
-	}
 }
 
 BitcoinExchange::~BitcoinExchange()
 {
-
+	if (_errFd != NO_FD)
+	{
+		_err.flush();
+		close(_errFd);
+	}
 }
 
 
@@ -33,29 +51,113 @@ BitcoinExchange::~BitcoinExchange()
 
 
 // --- methods ---
-static bool	dayIsInvalid(int day, int month, int year)
+int	BitcoinExchange::loadDatabase(const char* path, bool use_snapshot)
 {
-	if (day < 1 || day > 31)
-		return (true);
+	PROFILE_START(timer);
+	if (!loadDatabaseFile(path, use_snapshot, _index, _loadReport))
+		return (ERROR);
+	_ranges.build(_index);
+	PROFILE_STOP(PHASE_LOAD, timer);
+	return (OK);
+}
 
-	// february
-	if (month == 2)
-	{
-		if (year % 400 == 0 || (year % 4 == 0 && year % 100 != 0))
-		{
-			// leap year
-			if (day > 29)
-				return (true);
-		}
-		else if (day > 28)
-			return (true);
-	}
-	// april, june, september, november
-	else if ((month == 4 || month == 6 || month == 9 || month == 11)
-			&& day > 30)
-		return (true);
+// one more asset, answered for input lines that start with symbol
+int	BitcoinExchange::loadSeries(const std::string& symbol, const char* path,
+		bool use_snapshot)
+{
+	PROFILE_START(timer);
+	if (!_store.loadFile(symbol, path, use_snapshot))
+		return (ERROR);
+	PROFILE_STOP(PHASE_LOAD, timer);
+	return (OK);
+}
+
+// every asset of a "symbol,date,exchange_rate" table
+int	BitcoinExchange::loadSeriesTable(const char* path)
+{
+	PROFILE_START(timer);
+	if (!_store.loadTable(path, _tableReport))
+		return (ERROR);
+	PROFILE_STOP(PHASE_LOAD, timer);
+	return (OK);
+}
+
+// Call once everything is loaded: the default database answers lines
+// without a symbol and, unless another series took the name, DEFAULT_SYMBOL.
+void	BitcoinExchange::buildSymbolTable()
+{
+	PROFILE_START(timer);
+	_store.addExternal(DEFAULT_SYMBOL, _index, _ranges);
+	_store.seal();
+	PROFILE_STOP(PHASE_LOAD, timer);
+}
+
+const RateStore&	BitcoinExchange::store() const
+{
+	return (_store);
+}
 
-	return (false);
+const LoadReport&	BitcoinExchange::loadReport() const
+{
+	return (_loadReport);
+}
+
+// rows, skips and timing of the --db-table file, all symbols together
+const LoadReport&	BitcoinExchange::tableReport() const
+{
+	return (_tableReport);
+}
+
+const LookupStats&	BitcoinExchange::lookupStats() const
+{
+	return (_lookupStats);
+}
+
+bool	BitcoinExchange::enableDenseLookup(size_t budget_bytes)
+{
+	_store.buildDenseTables(budget_bytes);
+	return (_index.buildDenseTable(budget_bytes));
+}
+
+// rate statistics from one YYYY-MM-DD date to another, both included
+bool	BitcoinExchange::rangeStats(const std::string& from, const std::string& to,
+			RangeResult& result) const
+{
+	int	year, month, day;
+
+	if (from.size() != DATE_LEN || !parseDate(from.c_str(), year, month, day))
+		return (false);
+	int	from_day = daysFromCivil(year, month, day);
+	if (to.size() != DATE_LEN || !parseDate(to.c_str(), year, month, day))
+		return (false);
+
+	_ranges.query(from_day, daysFromCivil(year, month, day), result);
+	return (true);
+}
+
+// --plain: no ANSI colors and no separator rows
+void	BitcoinExchange::setPlainOutput(bool plain)
+{
+	_plain = plain;
+	_writer.setPlain(plain);
+}
+
+void	BitcoinExchange::setOutputFormat(OutputFormat format)
+{
+	_writer.setFormat(format);
+}
+
+// sends rejected lines to path instead of stderr
+int	BitcoinExchange::redirectErrors(const char* path)
+{
+	int	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	if (fd < 0)
+		return (ERROR);
+	_err.flush();
+	_err.setFd(fd);
+	_errFd = fd;
+	return (OK);
 }
 
 static bool	isOnlyDigit(std::string& str)
@@ -87,7 +189,7 @@ static bool	validInfileDate(std::string& token)
 	int	month_int = std::atoi(month_str.c_str());
 	int	day_int = std::atoi(day_str.c_str());
 
-	if (year_int <= 2000 || year_int > 2025)
+	if (year_int < INFILE_YEAR_MIN || year_int > INFILE_YEAR_MAX)
 		return (false);
 	if (month_int < 1 || month_int > 12)
 		return (false);
@@ -97,25 +199,28 @@ static bool	validInfileDate(std::string& token)
 	return (true);
 }
 
-static bool parseAndValidateValue(const std::string& token, float& infile_value)
+// the stream read keeps the original grammar, the range check is exact
+static bool parseAndValidateValue(const std::string& token)
 {
 	std::istringstream  iss(token);
 	char                check;
 	float               f;
+	const char*			cur = token.c_str();
+	Decimal				value;
 
-	if (!(iss >> f) || f < 0.0f || f > 1000.0f)
+	if (!(iss >> f) || (iss >> check))
 		return (false);
 
-	if (iss >> check)
+	if (!scanDecimal(cur, cur + token.size(), value)
+		|| value < 0 || value > INFILE_VALUE_MAX * DECIMAL_SCALE)
 		return (false);
 
-	infile_value = f;
 	return (true);
 }
 
 static bool	isValidLine(std::string& line,
 		std::string& infile_date,
-		float& infile_value,
+		std::string& infile_value,
 		const BitcoinExchange& obj)
 {
 	std::istringstream iss(line);
@@ -136,7 +241,7 @@ static bool	isValidLine(std::string& line,
 		obj.badLine(line);
 		return (false);
 	}
-	if (!parseAndValidateValue(value, infile_value))
+	if (!parseAndValidateValue(value))
 	{
 		obj.badValue(value);
 		return (false);
@@ -150,39 +255,264 @@ static bool	isValidLine(std::string& line,
 	}
 
 	infile_date = date;
+	infile_value = value;
 	return (true);
 }
 
-void    BitcoinExchange::transformLine(const std::string& infile_date, float infile_value)
+void    BitcoinExchange::transformLine(const std::string& infile_date,
+			const std::string& infile_value)
 {
-	std::map<std::string, float>::iterator it = _dbData.upper_bound(infile_date);
+	int				year, month, day;
+	InputLine		line;
+	const char*		cur = infile_value.c_str();
+	OutputBuffer	out(NO_FD, LINE_BUFFER_SIZE);
+	OutputBuffer	err(NO_FD, LINE_BUFFER_SIZE);
+
+	parseDate(infile_date.c_str(), year, month, day);
+	line.symbol = NULL;
+	line.symbol_len = 0;
+	line.day = daysFromCivil(year, month, day);
+	scanDecimal(cur, cur + infile_value.size(), line.value);
+	line.token = infile_date.c_str();
+	line.token_len = DATE_LEN;
+	line.amount = infile_value.c_str();
+	line.amount_len = infile_value.size();
+	convertLine(out, err, _legacyState, line, _index);
+	std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+	std::cout.flush();
+	std::cerr.write(err.data(), static_cast<std::streamsize>(err.size()));
+}
 
-	std::string	db_date;
-	float		db_value;
+// a value that overflows the fixed-point range is rejected as too large
+void	BitcoinExchange::convertLine(OutputBuffer& out, OutputBuffer& err,
+			ScanState& state, const InputLine& line, const RateIndex& index) const
+{
+	Conversion	conv;
+
+	PROFILE_START(timer);
+	bool	fits = resolveConversion(index, state.cursor, state.line_no, line,
+		conv);
+	PROFILE_LOOKUP(timer);
+	PROFILE_LINE(fits ? LINE_VALID : LINE_TOO_LARGE);
+
+	PROFILE_START(format_timer);
+	if (fits)
+		_writer.writeConversion(out, conv);
+	else
+		_writer.writeRejection(err, state.line_no, LINE_TOO_LARGE, line.amount,
+			line.amount_len);
+	PROFILE_STOP(PHASE_FORMAT, format_timer);
+}
 
-	if (it != _dbData.begin())
+// Reads the infile in READ_CHUNK blocks and scans whole lines in place;
+// diagnostics and output are the same as readInfileLegacy().
+void	BitcoinExchange::readInfile()
+{
+	std::vector<char>	buf(READ_CHUNK);
+	std::streambuf*		sb = _infile.rdbuf();
+	size_t				filled = 0;
+	ScanState			state;
+	bool				eof = false;
+
+	_writer.writeStreamHeader(_out);
+	while (!eof)
 	{
-		--it;
+		if (filled == buf.size())
+			buf.resize(buf.size() * 2);
+
+		std::streamsize	got = sb->sgetn(&buf[filled],
+				static_cast<std::streamsize>(buf.size() - filled));
+		if (got <= 0)
+			eof = true;
+		else
+			filled += static_cast<size_t>(got);
+
+		size_t	consumed = processLines(&buf[0], filled, eof, state,
+				_out, _err);
+		if (consumed < filled)
+			std::memmove(&buf[0], &buf[consumed], filled - consumed);
+		filled -= consumed;
+	}
+	addLookupStats(_lookupStats, state.cursor.stats);
+	_out.flush();
+	_err.flush();
+}
 
-		db_date = it->first;
-		db_value = it->second;
+// --threads mode: each round reads up to PARALLEL_CHUNK bytes per worker,
+// cuts them into newline-aligned chunks that the pool converts into
+// private buffers against the read-only index, then writes the buffers
+// back in input order, so stdout and stderr match readInfile() byte for
+// byte.
+void	BitcoinExchange::readInfileParallel(size_t threads)
+{
+	WorkerPool				pool(threads);
+	std::vector<char>		buf(threads * PARALLEL_CHUNK);
+	std::vector<ChunkJob*>	jobs(threads);
+	std::streambuf*			sb = _infile.rdbuf();
+	size_t					filled = 0;
+	size_t					line_no = 0;
+	bool					first_line = true;
+	bool					eof = false;
+
+	for (size_t i = 0; i < threads; i++)
+	{
+		jobs[i] = new ChunkJob();
+		jobs[i]->exchange = this;
 	}
-	else
+	_writer.writeStreamHeader(_out);
+
+	while (!eof)
 	{
-		db_date = "0";
-		db_value = 0.0f;
+		if (filled == buf.size())
+			buf.resize(buf.size() * 2);
+
+		std::streamsize	got = sb->sgetn(&buf[filled],
+				static_cast<std::streamsize>(buf.size() - filled));
+		if (got <= 0)
+			eof = true;
+		else
+			filled += static_cast<size_t>(got);
+
+		size_t	cut = filled;
+		if (!eof)
+		{
+			while (cut > 0 && buf[cut - 1] != '\n')
+				cut--;
+			if (cut == 0)
+				continue;
+		}
+
+		size_t	start = 0;
+		for (size_t i = 0; i < threads; i++)
+		{
+			size_t	stop = (i + 1 == threads) ? cut : cut / threads * (i + 1);
+
+			if (stop < start)
+				stop = start;
+			while (stop > 0 && stop < cut && buf[stop - 1] != '\n')
+				stop++;
+			jobs[i]->data = &buf[0] + start;
+			jobs[i]->len = stop - start;
+			jobs[i]->state.first_line = first_line && start == 0;
+			jobs[i]->state.line_no = line_no;
+			jobs[i]->out.clear();
+			jobs[i]->err.clear();
+			line_no += static_cast<size_t>(std::count(&buf[0] + start,
+					&buf[0] + stop, '\n'));
+			start = stop;
+		}
+		if (cut > 0)
+			first_line = false;
+
+		pool.run(processChunk, reinterpret_cast<void**>(&jobs[0]), threads);
+
+		for (size_t i = 0; i < threads; i++)
+		{
+			_out.append(jobs[i]->out.data(), jobs[i]->out.size());
+			_err.append(jobs[i]->err.data(), jobs[i]->err.size());
+		}
+
+		if (cut < filled)
+			std::memmove(&buf[0], &buf[cut], filled - cut);
+		filled -= cut;
 	}
 
-	std::ostringstream oss;
-	oss << db_value << " on " << db_date;
+	for (size_t i = 0; i < threads; i++)
+	{
+		addLookupStats(_lookupStats, jobs[i]->state.cursor.stats);
+		delete jobs[i];
+	}
+	_out.flush();
+	_err.flush();
+}
 
-	std::cout << GREEN " Valid: " RESET
-		<< infile_date << "  =>  " << infile_value
-		<< " (" << (db_date.compare("0") ? (oss.str()) : "no data") << ")"
-		<< " = " REVERSED " " << db_value * infile_value << " " RESET << std::endl;
+void	BitcoinExchange::processChunk(void* arg)
+{
+	ChunkJob*	job = static_cast<ChunkJob*>(arg);
+
+	job->exchange->processLines(job->data, job->len, true, job->state,
+		job->out, job->err);
 }
 
-void	BitcoinExchange::readInfile()
+// Handles every complete line of data (and the unterminated tail when
+// final is set) and advances state; returns the number of bytes consumed.
+size_t	BitcoinExchange::processLines(const char* data, size_t len, bool final,
+			ScanState& state, OutputBuffer& out, OutputBuffer& err) const
+{
+	const char*	cur = data;
+	const char*	end = data + len;
+
+	while (cur < end)
+	{
+		const char*	eol = static_cast<const char*>(std::memchr(cur, '\n',
+				static_cast<size_t>(end - cur)));
+		if (!eol && !final)
+			break;
+		const char*	line_end = eol ? eol : end;
+		state.line_no++;
+
+		// check header
+		if (state.first_line)
+		{
+			state.first_line = false;
+			if (static_cast<size_t>(line_end - cur) == std::strlen(INFILE_HEADER)
+				&& !std::memcmp(cur, INFILE_HEADER, std::strlen(INFILE_HEADER)))
+			{
+				cur = eol ? eol + 1 : end;
+				continue;
+			}
+			else
+				_writer.writeMissingHeader(err);
+		}
+
+		_writer.writeSeparator(out);
+
+		PROFILE_START(timer);
+		InputLine				line;
+		LineStatus				status = scanInputLine(cur, line_end, line);
+		const RateStore::Series*	series = NULL;
+		if (status <= LINE_RANGE && line.symbol_len)
+		{
+			series = _store.find(line.symbol, line.symbol_len);
+			if (!series)
+			{
+				status = LINE_BAD_SYMBOL;
+				line.token = line.symbol;
+				line.token_len = line.symbol_len;
+			}
+		}
+		PROFILE_STOP(PHASE_PARSE, timer);
+
+		if (status == LINE_VALID)
+			convertLine(out, err, state, line, series ? *series->index : _index);
+		else if (status == LINE_RANGE)
+		{
+			RangeResult	range;
+
+			PROFILE_START(lookup_timer);
+			(series ? *series->ranges : _ranges).query(line.day, line.to_day,
+				range);
+			PROFILE_LOOKUP(lookup_timer);
+			PROFILE_LINE(status);
+			PROFILE_START(format_timer);
+			_writer.writeRange(out, err, state.line_no, line, range);
+			PROFILE_STOP(PHASE_FORMAT, format_timer);
+		}
+		else
+		{
+			PROFILE_LINE(status);
+			PROFILE_START(format_timer);
+			_writer.writeRejection(err, state.line_no, status, line.token,
+				line.token_len);
+			PROFILE_STOP(PHASE_FORMAT, format_timer);
+		}
+		cur = eol ? eol + 1 : end;
+	}
+	return (static_cast<size_t>(cur - data));
+}
+
+// original getline/istringstream reader, kept as a reference for benchmarks
+void	BitcoinExchange::readInfileLegacy()
 {
 	std::string	line;
 	bool		first_line = true;
@@ -193,22 +523,27 @@ void	BitcoinExchange::readInfile()
 		if (first_line)
 		{
 			first_line = false;
-			if (line.compare("date | value") == OK)
+			if (line.compare(INFILE_HEADER) == OK)
 				continue;
 			else
 				missingHeader();
 		}
 
-		std::cout << " ------------------------------------------------------------ " << std::endl;
+		if (!_plain)
+			std::cout << " ------------------------------------------------------------ " << std::endl;
 
 		std::string	infile_date;
-		float		infile_value;
+		std::string	infile_value;
 
-		if (!isValidLine(line, infile_date, infile_value, *this))
+		PROFILE_START(timer);
+		bool	valid = isValidLine(line, infile_date, infile_value, *this);
+		PROFILE_STOP(PHASE_PARSE, timer);
+		if (!valid)
 			continue;
 
 		transformLine(infile_date, infile_value);
 	}
+	addLookupStats(_lookupStats, _legacyState.cursor.stats);
 }
 
 
@@ -218,23 +553,33 @@ void	BitcoinExchange::readInfile()
 // --- errors ---
 void	BitcoinExchange::missingHeader() const
 {
-	std::cerr << RED " Error:" RESET << " missing header => date | value" << std::endl;
+	OutputBuffer	line(NO_FD, LINE_BUFFER_SIZE);
+
+	_writer.writeMissingHeader(line);
+	std::cerr.write(line.data(), static_cast<std::streamsize>(line.size()));
 }
 
-void	BitcoinExchange::badLine(const std::string& line) const
+void	BitcoinExchange::badLine(const std::string& input) const
 {
-	std::cerr << RED " Error:" RESET << " bad line    =>  ";
-	std::cerr << ORANGE << (!line.empty() ? line : "(empty)") << RESET << std::endl;
+	reportRejection(LINE_BAD_LINE, input);
 }
 
 void	BitcoinExchange::badDate(const std::string& date) const
 {
-	std::cerr << RED " Error:" RESET << " bad date    =>  ";
-	std::cerr << ORANGE << date << RESET << std::endl;
+	reportRejection(LINE_BAD_DATE, date);
 }
 
 void	BitcoinExchange::badValue(const std::string& value) const
 {
-	std::cerr << RED " Error:" RESET << " bad value   =>  ";
-	std::cerr << ORANGE << value << RESET << std::endl;
+	reportRejection(LINE_BAD_VALUE, value);
+}
+
+void	BitcoinExchange::reportRejection(LineStatus status,
+			const std::string& token) const
+{
+	OutputBuffer	line(NO_FD, LINE_BUFFER_SIZE);
+
+	PROFILE_LINE(status);
+	_writer.writeRejection(line, 0, status, token.data(), token.size());
+	std::cerr.write(line.data(), static_cast<std::streamsize>(line.size()));
 }
@@ -0,0 +1,164 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "dictionary.hpp"
+#include "DatabaseTail.class.hpp"
+
+// --- helper functions declaration ---
+static bool	readAt(int fd, char* buf, size_t len, size_t offset);
+static bool	lineStart(int fd, size_t& offset);
+
+// --- constructors / destructor ---
+DatabaseTail::DatabaseTail()
+	: _offset(0), _dev(0), _ino(0), _started(false)
+{
+
+}
+
+DatabaseTail::~DatabaseTail()
+{
+
+}
+
+
+
+
+
+// --- methods ---
+// Starts following path after the first offset bytes, the part already
+// loaded. A trailing partial line is read again once it is complete; its
+// row then simply overwrites whatever the truncated one produced.
+bool	DatabaseTail::start(const char* path, size_t offset)
+{
+	_started = false;
+
+	int	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return (false);
+
+	struct stat	st;
+	bool		ok = (fstat(fd, &st) == 0);
+	if (ok)
+	{
+		if (offset > static_cast<size_t>(st.st_size))
+			offset = static_cast<size_t>(st.st_size);
+		ok = lineStart(fd, offset);
+	}
+	close(fd);
+	if (!ok)
+		return (false);
+
+	_path = path;
+	_offset = offset;
+	_dev = st.st_dev;
+	_ino = st.st_ino;
+	_started = true;
+	return (true);
+}
+
+// Reads whatever complete lines were appended since the last call into
+// index and finalizes it; the cost depends only on the new bytes and rows.
+TailStatus	DatabaseTail::poll(RateIndex& index, TailReport& report)
+{
+	std::memset(&report, 0, sizeof(report));
+	if (!_started)
+		return (TAIL_FAILED);
+
+	int	fd = open(_path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return (errno == ENOENT ? TAIL_REPLACED : TAIL_FAILED);
+
+	struct stat	st;
+	if (fstat(fd, &st) < 0)
+	{
+		close(fd);
+		return (TAIL_FAILED);
+	}
+	if (st.st_dev != _dev || st.st_ino != _ino
+		|| static_cast<size_t>(st.st_size) < _offset)
+	{
+		close(fd);
+		return (TAIL_REPLACED);
+	}
+
+	size_t				len = static_cast<size_t>(st.st_size) - _offset;
+	std::vector<char>	delta(len);
+	if (len == 0 || !readAt(fd, &delta[0], len, _offset))
+	{
+		close(fd);
+		return (len == 0 ? TAIL_UNCHANGED : TAIL_FAILED);
+	}
+	close(fd);
+
+	// only complete lines; a row still being written waits for next time
+	while (len > 0 && delta[len - 1] != '\n')
+		len--;
+	if (len == 0)
+		return (TAIL_UNCHANGED);
+
+	LoadReport	parsed;
+	size_t		before = index.size();
+
+	std::memset(&parsed, 0, sizeof(parsed));
+	parseRateCsv(&delta[0], len, index, parsed);
+	report.changed_from = index.finalize();
+	_offset += len;
+
+	report.rows = parsed.rows;
+	report.skipped = parsed.skipped;
+	report.bytes = len;
+	report.added = index.size() - before;
+	return (TAIL_APPENDED);
+}
+
+size_t	DatabaseTail::offset() const
+{
+	return (_offset);
+}
+
+
+
+
+
+// --- helper functions definition ---
+static bool	readAt(int fd, char* buf, size_t len, size_t offset)
+{
+	while (len > 0)
+	{
+		ssize_t	got = pread(fd, buf, len, static_cast<off_t>(offset));
+
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			return (false);
+		buf += got;
+		len -= static_cast<size_t>(got);
+		offset += static_cast<size_t>(got);
+	}
+	return (true);
+}
+
+// moves offset back to the start of the line it falls in
+static bool	lineStart(int fd, size_t& offset)
+{
+	char	buf[LINE_BUFFER_SIZE];
+
+	while (offset > 0)
+	{
+		size_t	len = offset < sizeof(buf) ? offset : sizeof(buf);
+
+		if (!readAt(fd, buf, len, offset - len))
+			return (false);
+		for (size_t i = len; i > 0; i--)
+		{
+			if (buf[i - 1] == '\n')
+				return (true);
+			offset--;
+		}
+	}
+	return (true);
+}
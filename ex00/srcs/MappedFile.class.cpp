@@ -0,0 +1,81 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MappedFile.class.hpp"
+
+// --- constructors / destructor ---
+MappedFile::MappedFile()
+	: _addr(NULL), _size(0), _open(false)
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+
+
+
+
+// --- methods ---
+bool	MappedFile::open(const char* path)
+{
+	close();
+
+	int	fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return (false);
+
+	struct stat	st;
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode))
+	{
+		::close(fd);
+		return (false);
+	}
+
+	_size = static_cast<size_t>(st.st_size);
+	if (_size > 0)
+	{
+		_addr = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (_addr == MAP_FAILED)
+		{
+			_addr = NULL;
+			_size = 0;
+			::close(fd);
+			return (false);
+		}
+		madvise(_addr, _size, MADV_SEQUENTIAL);
+	}
+	::close(fd);
+
+	_open = true;
+	return (true);
+}
+
+void	MappedFile::close()
+{
+	if (_addr)
+		munmap(_addr, _size);
+	_addr = NULL;
+	_size = 0;
+	_open = false;
+}
+
+const char*	MappedFile::data() const
+{
+	return (static_cast<const char*>(_addr));
+}
+
+size_t	MappedFile::size() const
+{
+	return (_size);
+}
+
+bool	MappedFile::isOpen() const
+{
+	return (_open);
+}
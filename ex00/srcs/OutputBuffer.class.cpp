@@ -0,0 +1,242 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include "OutputBuffer.class.hpp"
+
+#define NUMBER_MAX 32
+#define PRECISION_MAX 9
+
+// --- helper functions declaration ---
+static size_t	formatGeneral(double value, int precision, char* out);
+
+// --- constructors / destructor ---
+OutputBuffer::OutputBuffer(int fd, size_t capacity)
+	: _fd(fd), _buf(capacity), _len(0), _lineBuffered(false)
+{
+
+}
+
+OutputBuffer::~OutputBuffer()
+{
+	flush();
+}
+
+
+
+
+
+// --- methods ---
+void	OutputBuffer::append(const char* str, size_t len)
+{
+	reserve(len);
+	std::memcpy(&_buf[_len], str, len);
+	_len += len;
+}
+
+void	OutputBuffer::append(const char* str)
+{
+	append(str, std::strlen(str));
+}
+
+void	OutputBuffer::append(char c)
+{
+	reserve(1);
+	_buf[_len++] = c;
+}
+
+// same text as printf("%.*g", precision, value); the default precision
+// is what operator<< prints
+void	OutputBuffer::appendNumber(double value, int precision)
+{
+	reserve(NUMBER_MAX);
+	_len += formatGeneral(value, precision, &_buf[_len]);
+}
+
+void	OutputBuffer::appendDecimal(Decimal value)
+{
+	reserve(DECIMAL_TEXT_MAX);
+	_len += formatDecimal(value, &_buf[_len]);
+}
+
+void	OutputBuffer::endLine()
+{
+	append('\n');
+	if (_lineBuffered)
+		flush();
+}
+
+void	OutputBuffer::flush()
+{
+	if (_fd == NO_FD)
+		return ;
+
+	const char*	cur = _buf.empty() ? NULL : &_buf[0];
+	size_t		left = _len;
+
+	while (left > 0)
+	{
+		ssize_t	written = write(_fd, cur, left);
+
+		if (written <= 0)
+			break;
+		cur += written;
+		left -= static_cast<size_t>(written);
+	}
+	_len = 0;
+}
+
+void	OutputBuffer::clear()
+{
+	_len = 0;
+}
+
+void	OutputBuffer::setFd(int fd)
+{
+	_fd = fd;
+}
+
+void	OutputBuffer::setLineBuffered(bool line_buffered)
+{
+	_lineBuffered = line_buffered;
+}
+
+const char*	OutputBuffer::data() const
+{
+	return (_buf.empty() ? NULL : &_buf[0]);
+}
+
+size_t	OutputBuffer::size() const
+{
+	return (_len);
+}
+
+// makes room for extra bytes: flushes when bound to a descriptor, grows
+// otherwise (or when a single append is larger than the whole buffer)
+void	OutputBuffer::reserve(size_t extra)
+{
+	if (_len + extra <= _buf.size())
+		return ;
+	if (_fd != NO_FD)
+		flush();
+	if (_len + extra > _buf.size())
+		_buf.resize((_len + extra) * 2);
+}
+
+
+
+
+
+// --- helper functions definition ---
+// Fast %g: rounds to precision significant digits in one multiplication
+// and only falls back to sprintf when that rounding is too close to a tie
+// to be trusted (or for very large or small values, infinities and NaN).
+static size_t	formatGeneral(double value, int precision, char* out)
+{
+	static const double	pow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	double	magnitude = std::fabs(value);
+
+	if (value == 0.0)
+	{
+		size_t	len = 0;
+
+		if (std::signbit(value))
+			out[len++] = '-';
+		out[len++] = '0';
+		return (len);
+	}
+	if (!(magnitude >= 1e-12 && magnitude < 1e12)
+		|| precision < 1 || precision > PRECISION_MAX)
+		return (static_cast<size_t>(std::sprintf(out, "%.*g", precision, value)));
+
+	int		exp10 = 0;
+	double	scaled = 0.0;
+
+	while (magnitude >= pow10[exp10 + 1])
+		exp10++;
+	while (exp10 > -12 && magnitude < 1.0 / pow10[-exp10])
+		exp10--;
+
+	// exp10 is only a first guess near powers of ten: settle it on the
+	// scaled value so it always has exactly precision digits before rounding
+	double	low = pow10[precision - 1] - 0.5;
+	double	high = pow10[precision] - 0.5;
+	for (int tries = 0; tries < 3; tries++)
+	{
+		int	shift = precision - 1 - exp10;
+
+		scaled = (shift >= 0) ? magnitude * pow10[shift] : magnitude / pow10[-shift];
+		if (scaled >= high)
+			exp10++;
+		else if (scaled < low)
+			exp10--;
+		else
+			break;
+	}
+
+	double	rounded = std::floor(scaled + 0.5);
+	double	frac = scaled - std::floor(scaled);
+
+	if (scaled < low || scaled >= high || std::fabs(frac - 0.5) < 1e-6)
+		return (static_cast<size_t>(std::sprintf(out, "%.*g", precision, value)));
+
+	unsigned long	digits = static_cast<unsigned long>(rounded);
+
+	char	buf[PRECISION_MAX];
+	for (int i = precision - 1; i >= 0; i--)
+	{
+		buf[i] = static_cast<char>('0' + digits % 10);
+		digits /= 10;
+	}
+	int	ndigits = precision;
+	while (ndigits > 1 && buf[ndigits - 1] == '0')
+		ndigits--;
+
+	size_t	len = 0;
+	if (value < 0)
+		out[len++] = '-';
+
+	if (exp10 >= -4 && exp10 < precision)
+	{
+		if (exp10 < 0)
+		{
+			out[len++] = '0';
+			out[len++] = '.';
+			for (int i = -1; i > exp10; i--)
+				out[len++] = '0';
+			for (int i = 0; i < ndigits; i++)
+				out[len++] = buf[i];
+		}
+		else
+		{
+			for (int i = 0; i <= exp10; i++)
+				out[len++] = (i < ndigits) ? buf[i] : '0';
+			if (ndigits > exp10 + 1)
+			{
+				out[len++] = '.';
+				for (int i = exp10 + 1; i < ndigits; i++)
+					out[len++] = buf[i];
+			}
+		}
+	}
+	else
+	{
+		out[len++] = buf[0];
+		if (ndigits > 1)
+		{
+			out[len++] = '.';
+			for (int i = 1; i < ndigits; i++)
+				out[len++] = buf[i];
+		}
+		int	e = exp10 < 0 ? -exp10 : exp10;
+		out[len++] = 'e';
+		out[len++] = exp10 < 0 ? '-' : '+';
+		out[len++] = static_cast<char>('0' + e / 10);
+		out[len++] = static_cast<char>('0' + e % 10);
+	}
+	return (len);
+}
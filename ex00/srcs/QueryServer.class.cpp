@@ -0,0 +1,656 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "dictionary.hpp"
+#include "QueryServer.class.hpp"
+#include "snapshot.hpp"
+
+#define LATENCY_CAP_NS 0xffffffffUL
+
+// --- helper functions declaration ---
+static volatile sig_atomic_t	g_stop = 0;
+static int						g_wakeFd = -1;
+
+static void		onStopSignal(int sig);
+static void		wakeAcceptLoop();
+static bool		openWakePipe(int fds[2]);
+static bool		waitForClient(int listen_fd, int wake_fd);
+static uint64_t	nowNs();
+static bool		isCommand(const char* line, const char* end, const char* name);
+static void		appendCount(OutputBuffer& out, size_t value);
+static void		appendMicros(OutputBuffer& out, uint32_t ns);
+
+// --- constructors / destructor ---
+QueryServer::QueryServer(const char* db_path, bool use_snapshot, bool dense,
+		size_t dense_budget)
+	: _dbPath(db_path), _useSnapshot(use_snapshot), _dense(dense),
+	_denseBudget(dense_budget), _current(NULL), _generation(0),
+	_latencies(LATENCY_WINDOW), _latencyNext(0), _queries(0), _reloads(0)
+{
+	pthread_mutex_init(&_versionMutex, NULL);
+	pthread_mutex_init(&_reloadMutex, NULL);
+	pthread_mutex_init(&_statsMutex, NULL);
+	pthread_mutex_init(&_clientsMutex, NULL);
+	pthread_cond_init(&_clientsDone, NULL);
+	_writer.setPlain(true);
+}
+
+QueryServer::~QueryServer()
+{
+	if (_current)
+		release(_current);
+
+	pthread_cond_destroy(&_clientsDone);
+	pthread_mutex_destroy(&_clientsMutex);
+	pthread_mutex_destroy(&_statsMutex);
+	pthread_mutex_destroy(&_reloadMutex);
+	pthread_mutex_destroy(&_versionMutex);
+}
+
+QueryServer::IndexVersion::IndexVersion()
+	: refs(0), generation(0)
+{
+	std::memset(&report, 0, sizeof(report));
+	pthread_rwlock_init(&lock, NULL);
+}
+
+QueryServer::IndexVersion::~IndexVersion()
+{
+	pthread_rwlock_destroy(&lock);
+}
+
+QueryServer::Session::Session()
+	: version(NULL), generation(0), requests(0)
+{
+
+}
+
+
+
+
+
+// --- methods ---
+int	QueryServer::load()
+{
+	IndexVersion*	version = loadVersion();
+
+	if (!version)
+		return (ERROR);
+	pthread_mutex_lock(&_versionMutex);
+	_current = version;
+	pthread_mutex_unlock(&_versionMutex);
+	return (OK);
+}
+
+void	QueryServer::setFormat(OutputFormat format)
+{
+	_writer.setFormat(format);
+}
+
+int	QueryServer::serveStream(int in_fd, int out_fd)
+{
+	serveConnection(in_fd, out_fd);
+	return (OK);
+}
+
+// Accepts clients on a Unix stream socket, one thread each, until SIGINT
+// or SIGTERM; then wakes the remaining clients and waits for them. Only a
+// stale socket is removed from the path, any other file there is an error.
+// The signals are blocked in client threads and wake the accept loop
+// through a self-pipe, so a stop can neither be missed nor land elsewhere.
+int	QueryServer::serveSocket(const char* socket_path)
+{
+	struct sockaddr_un	addr;
+	struct stat			st;
+	int					wake[2];
+
+	if (std::strlen(socket_path) >= sizeof(addr.sun_path))
+		return (ERROR);
+	if (lstat(socket_path, &st) == 0)
+	{
+		if (!S_ISSOCK(st.st_mode))
+			return (ERROR);
+		unlink(socket_path);
+	}
+
+	int	listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listen_fd < 0)
+		return (ERROR);
+
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	std::strcpy(addr.sun_path, socket_path);
+	if (bind(listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0
+		|| listen(listen_fd, SERVER_BACKLOG) < 0
+		|| fcntl(listen_fd, F_SETFL, O_NONBLOCK) < 0)
+	{
+		close(listen_fd);
+		return (ERROR);
+	}
+	if (!openWakePipe(wake))
+	{
+		close(listen_fd);
+		unlink(socket_path);
+		return (ERROR);
+	}
+	g_wakeFd = wake[1];
+
+	struct sigaction	sa;
+	std::memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = onStopSignal;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	sigset_t	stop_signals;
+	sigset_t	old_mask;
+	sigemptyset(&stop_signals);
+	sigaddset(&stop_signals, SIGINT);
+	sigaddset(&stop_signals, SIGTERM);
+
+	while (!g_stop && waitForClient(listen_fd, wake[0]))
+	{
+		int	fd = accept(listen_fd, NULL, NULL);
+
+		if (fd < 0)
+		{
+			if (errno == EINTR || errno == EAGAIN || errno == ECONNABORTED)
+				continue;
+			break;
+		}
+
+		Connection*	conn = new Connection();
+		pthread_t	thread;
+		int			created;
+
+		conn->server = this;
+		conn->fd = fd;
+		pthread_mutex_lock(&_clientsMutex);
+		_clients.push_back(fd);
+		pthread_mutex_unlock(&_clientsMutex);
+		// the client thread inherits the mask with both signals blocked
+		pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+		created = pthread_create(&thread, NULL, connectionMain, conn);
+		pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+		if (created != 0)
+		{
+			pthread_mutex_lock(&_clientsMutex);
+			_clients.erase(std::find(_clients.begin(), _clients.end(), fd));
+			pthread_mutex_unlock(&_clientsMutex);
+			close(fd);
+			delete conn;
+			continue;
+		}
+		pthread_detach(thread);
+	}
+
+	close(listen_fd);
+	unlink(socket_path);
+	g_wakeFd = -1;
+	close(wake[0]);
+	close(wake[1]);
+
+	pthread_mutex_lock(&_clientsMutex);
+	for (size_t i = 0; i < _clients.size(); i++)
+		shutdown(_clients[i], SHUT_RDWR);
+	while (!_clients.empty())
+		pthread_cond_wait(&_clientsDone, &_clientsMutex);
+	pthread_mutex_unlock(&_clientsMutex);
+	return (OK);
+}
+
+void	QueryServer::requestStop()
+{
+	g_stop = 1;
+	wakeAcceptLoop();
+}
+
+QueryServer::IndexVersion*	QueryServer::loadVersion()
+{
+	IndexVersion*	version = new IndexVersion();
+
+	version->refs = 1;
+	if (!loadDatabaseFile(_dbPath.c_str(), _useSnapshot, version->index,
+			version->report))
+	{
+		delete version;
+		return (NULL);
+	}
+	if (_dense)
+		version->index.buildDenseTable(_denseBudget);
+	version->ranges.build(version->index);
+	version->tail.start(_dbPath.c_str(), version->report.source_size);
+	return (version);
+}
+
+// pins the current index version for one batch of requests
+QueryServer::IndexVersion*	QueryServer::acquire()
+{
+	pthread_mutex_lock(&_versionMutex);
+	IndexVersion*	version = _current;
+	version->refs++;
+	pthread_mutex_unlock(&_versionMutex);
+	return (version);
+}
+
+void	QueryServer::release(IndexVersion* version)
+{
+	pthread_mutex_lock(&_versionMutex);
+	bool	last = (--version->refs == 0);
+	pthread_mutex_unlock(&_versionMutex);
+	if (last)
+		delete version;
+}
+
+// pins the current version for reading and drops a stale merge cursor
+void	QueryServer::pin(Session& session)
+{
+	session.version = acquire();
+	pthread_rwlock_rdlock(&session.version->lock);
+	if (session.version->generation != session.generation)
+	{
+		session.generation = session.version->generation;
+		session.cursor = RateIndex::Cursor();
+	}
+}
+
+void	QueryServer::unpin(Session& session)
+{
+	pthread_rwlock_unlock(&session.version->lock);
+	release(session.version);
+	session.version = NULL;
+}
+
+// Loads a fresh index outside every lock queries take, then swaps it in;
+// batches still running on the old version keep it alive until they end.
+bool	QueryServer::reload(OutputBuffer& out)
+{
+	pthread_mutex_lock(&_reloadMutex);
+	IndexVersion*	fresh = loadVersion();
+	if (!fresh)
+	{
+		pthread_mutex_unlock(&_reloadMutex);
+		out.append("ERR reload failed");
+		out.endLine();
+		return (false);
+	}
+
+	pthread_mutex_lock(&_versionMutex);
+	IndexVersion*	old = _current;
+	fresh->generation = ++_generation;
+	_current = fresh;
+	pthread_mutex_unlock(&_versionMutex);
+	pthread_mutex_unlock(&_reloadMutex);
+	release(old);
+
+	pthread_mutex_lock(&_statsMutex);
+	_reloads++;
+	pthread_mutex_unlock(&_statsMutex);
+
+	out.append("OK reload ");
+	appendCount(out, fresh->index.size());
+	out.append(" rows generation ");
+	appendCount(out, fresh->generation);
+	out.endLine();
+	return (true);
+}
+
+// Applies the rows appended to the database since the current version was
+// loaded or last refreshed, and updates the range index from the first
+// row they changed. A database that was rewritten rather than appended to
+// falls back to a full reload.
+bool	QueryServer::refresh(OutputBuffer& out)
+{
+	pthread_mutex_lock(&_reloadMutex);
+	IndexVersion*	version = acquire();
+	TailReport		report;
+
+	pthread_rwlock_wrlock(&version->lock);
+	TailStatus	status = version->tail.poll(version->index, report);
+	if (status == TAIL_APPENDED)
+	{
+		version->ranges.update(version->index, report.changed_from);
+		version->generation = ++_generation;
+	}
+	unsigned long	generation = version->generation;
+	pthread_rwlock_unlock(&version->lock);
+	release(version);
+	pthread_mutex_unlock(&_reloadMutex);
+
+	if (status == TAIL_REPLACED)
+		return (reload(out));
+	if (status == TAIL_FAILED)
+	{
+		out.append("ERR refresh failed");
+		out.endLine();
+		return (false);
+	}
+
+	out.append("OK refresh ");
+	appendCount(out, report.rows);
+	out.append(" rows ");
+	appendCount(out, report.added);
+	out.append(" new dates generation ");
+	appendCount(out, generation);
+	out.endLine();
+	return (true);
+}
+
+void*	QueryServer::connectionMain(void* arg)
+{
+	Connection*		conn = static_cast<Connection*>(arg);
+	QueryServer*	server = conn->server;
+	int				fd = conn->fd;
+
+	delete conn;
+	server->serveConnection(fd, fd);
+
+	pthread_mutex_lock(&server->_clientsMutex);
+	server->_clients.erase(std::find(server->_clients.begin(),
+		server->_clients.end(), fd));
+	if (server->_clients.empty())
+		pthread_cond_broadcast(&server->_clientsDone);
+	pthread_mutex_unlock(&server->_clientsMutex);
+	close(fd);
+	return (NULL);
+}
+
+// Reads whatever the client sent, answers all complete lines in one write.
+// The replies build up unbound and are written only once the batch has
+// unpinned its version, so a client that stops reading blocks only its
+// own thread, never a RELOAD or REFRESH waiting for the version's lock.
+void	QueryServer::serveConnection(int in_fd, int out_fd)
+{
+	std::vector<char>	buf(SERVER_READ_CHUNK);
+	OutputBuffer		out(NO_FD, OUTPUT_BUFFER_SIZE);
+	Session				session;
+	size_t				filled = 0;
+	bool				quit = false;
+	bool				eof = false;
+
+	while (!quit && !eof)
+	{
+		if (filled == buf.size())
+			buf.resize(buf.size() * 2);
+
+		ssize_t	got = read(in_fd, &buf[filled], buf.size() - filled);
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			eof = true;
+		else
+			filled += static_cast<size_t>(got);
+
+		size_t	consumed = handleBatch(&buf[0], filled, eof, session, out, quit);
+		out.setFd(out_fd);
+		out.flush();
+		out.setFd(NO_FD);
+		recordLatencies(session);
+
+		if (consumed < filled)
+			std::memmove(&buf[0], &buf[consumed], filled - consumed);
+		filled -= consumed;
+	}
+}
+
+size_t	QueryServer::handleBatch(const char* data, size_t len, bool final,
+			Session& session, OutputBuffer& out, bool& quit)
+{
+	const char*	cur = data;
+	const char*	end = data + len;
+
+	pin(session);
+
+	while (cur < end && !quit)
+	{
+		const char*	eol = static_cast<const char*>(std::memchr(cur, '\n',
+				static_cast<size_t>(end - cur)));
+		if (!eol && !final)
+			break;
+		const char*	line_end = eol ? eol : end;
+
+		if (line_end > cur && line_end[-1] == '\r')
+			line_end--;
+		quit = !handleRequest(cur, line_end, session, out);
+		cur = eol ? eol + 1 : end;
+	}
+
+	unpin(session);
+	return (static_cast<size_t>(cur - data));
+}
+
+// answers one request line; returns false on QUIT
+bool	QueryServer::handleRequest(const char* line, const char* end,
+			Session& session, OutputBuffer& out)
+{
+	if (isCommand(line, end, "QUIT"))
+		return (false);
+	if (isCommand(line, end, "STATS"))
+	{
+		recordLatencies(session);
+		writeStats(out);
+		return (true);
+	}
+	// both need the version unpinned; the rest of the batch sees the result
+	if (isCommand(line, end, "RELOAD"))
+	{
+		unpin(session);
+		reload(out);
+		pin(session);
+		return (true);
+	}
+	if (isCommand(line, end, "REFRESH"))
+	{
+		unpin(session);
+		refresh(out);
+		pin(session);
+		return (true);
+	}
+
+	uint64_t	start = nowNs();
+	InputLine	input;
+	LineStatus	status = scanInputLine(line, end, input);
+
+	session.requests++;
+	// the server holds data.csv only, which answers to DEFAULT_SYMBOL
+	if (status <= LINE_RANGE && input.symbol_len
+		&& std::string(input.symbol, input.symbol_len) != DEFAULT_SYMBOL)
+	{
+		status = LINE_BAD_SYMBOL;
+		input.token = input.symbol;
+		input.token_len = input.symbol_len;
+	}
+	if (status == LINE_VALID)
+	{
+		Conversion	conv;
+
+		if (resolveConversion(session.version->index, session.cursor,
+				session.requests, input, conv))
+			_writer.writeConversion(out, conv);
+		else
+			_writer.writeRejection(out, session.requests, LINE_TOO_LARGE,
+				input.amount, input.amount_len);
+	}
+	else if (status == LINE_RANGE)
+	{
+		RangeResult	range;
+
+		session.version->ranges.query(input.day, input.to_day, range);
+		_writer.writeRange(out, out, session.requests, input, range);
+	}
+	else
+		_writer.writeRejection(out, session.requests, status, input.token,
+			input.token_len);
+
+	uint64_t	elapsed = nowNs() - start;
+	session.latencies.push_back(static_cast<uint32_t>(
+		std::min<uint64_t>(elapsed, LATENCY_CAP_NS)));
+	return (true);
+}
+
+// latency percentiles over the last LATENCY_WINDOW queries, in microseconds
+void	QueryServer::writeStats(OutputBuffer& out)
+{
+	std::vector<uint32_t>	window;
+	size_t					queries, reloads;
+
+	pthread_mutex_lock(&_statsMutex);
+	queries = _queries;
+	reloads = _reloads;
+	window.assign(_latencies.begin(), _latencies.begin()
+		+ static_cast<long>(std::min(_queries, _latencies.size())));
+	pthread_mutex_unlock(&_statsMutex);
+
+	std::sort(window.begin(), window.end());
+
+	static const double	ranks[] = {0.50, 0.90, 0.99, 0.999};
+	static const char*	names[] = {" p50=", " p90=", " p99=", " p999="};
+
+	out.append("STATS queries=");
+	appendCount(out, queries);
+	out.append(" reloads=");
+	appendCount(out, reloads);
+	for (size_t i = 0; i < sizeof(ranks) / sizeof(ranks[0]); i++)
+	{
+		out.append(names[i]);
+		if (window.empty())
+			out.append('-');
+		else
+			appendMicros(out, window[static_cast<size_t>(ranks[i]
+				* static_cast<double>(window.size() - 1))]);
+	}
+	out.append(" max=");
+	if (window.empty())
+		out.append('-');
+	else
+		appendMicros(out, window.back());
+	out.endLine();
+}
+
+void	QueryServer::recordLatencies(Session& session)
+{
+	if (session.latencies.empty())
+		return ;
+
+	pthread_mutex_lock(&_statsMutex);
+	for (size_t i = 0; i < session.latencies.size(); i++)
+	{
+		_latencies[_latencyNext] = session.latencies[i];
+		_latencyNext = (_latencyNext + 1) % _latencies.size();
+	}
+	_queries += session.latencies.size();
+	pthread_mutex_unlock(&_statsMutex);
+	session.latencies.clear();
+}
+
+
+
+
+
+// --- helper functions definition ---
+static void	onStopSignal(int sig)
+{
+	(void)sig;
+	g_stop = 1;
+	wakeAcceptLoop();
+}
+
+// async-signal-safe: one byte into the non-blocking self-pipe
+static void	wakeAcceptLoop()
+{
+	int		fd = g_wakeFd;
+	char	byte = 0;
+
+	if (fd >= 0 && write(fd, &byte, 1) < 0)
+		return ;
+}
+
+static bool	openWakePipe(int fds[2])
+{
+	if (pipe(fds) < 0)
+		return (false);
+	for (int i = 0; i < 2; i++)
+	{
+		if (fcntl(fds[i], F_SETFL, O_NONBLOCK) < 0
+			|| fcntl(fds[i], F_SETFD, FD_CLOEXEC) < 0)
+		{
+			close(fds[0]);
+			close(fds[1]);
+			return (false);
+		}
+	}
+	return (true);
+}
+
+// blocks until a client is waiting (true) or the self-pipe is written
+// (false); a stop that came before the call is already in the pipe
+static bool	waitForClient(int listen_fd, int wake_fd)
+{
+	struct pollfd	fds[2];
+
+	fds[0].fd = listen_fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = wake_fd;
+	fds[1].events = POLLIN;
+	while (true)
+	{
+		fds[0].revents = 0;
+		fds[1].revents = 0;
+		if (poll(fds, 2, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return (false);
+		}
+		if (fds[1].revents)
+			return (false);
+		if (fds[0].revents & POLLIN)
+			return (true);
+		if (fds[0].revents)
+			return (false);
+	}
+}
+
+static uint64_t	nowNs()
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL
+		+ static_cast<uint64_t>(ts.tv_nsec));
+}
+
+static bool	isCommand(const char* line, const char* end, const char* name)
+{
+	size_t	len = std::strlen(name);
+
+	return (static_cast<size_t>(end - line) == len && !std::memcmp(line, name, len));
+}
+
+static void	appendCount(OutputBuffer& out, size_t value)
+{
+	char	digits[24];
+	size_t	len = 0;
+
+	do
+	{
+		digits[sizeof(digits) - ++len] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value);
+	out.append(digits + sizeof(digits) - len, len);
+}
+
+static void	appendMicros(OutputBuffer& out, uint32_t ns)
+{
+	out.appendNumber(static_cast<double>(ns) / 1000.0, 4);
+	out.append("us");
+}
@@ -0,0 +1,202 @@
+#include <algorithm>
+
+#include "RangeIndex.class.hpp"
+
+// --- helper functions declaration ---
+static size_t	floorLog2(size_t value);
+
+// --- constructors / destructor ---
+RangeIndex::RangeIndex()
+	: _index(NULL), _blocks(0)
+{
+
+}
+
+RangeIndex::~RangeIndex()
+{
+
+}
+
+
+
+
+
+// --- methods ---
+void	RangeIndex::build(const RateIndex& index)
+{
+	_rateSums.clear();
+	_timeSums.clear();
+	_blockMin.clear();
+	_blockMax.clear();
+	update(index, 0);
+}
+
+// Rows before from are unchanged since the last build() or update(). The
+// time sum of a row depends on the date after it, so one more row before
+// from is redone; level k of the sparse table holds, for each block b, the
+// extremes of the 2^k blocks ending at b, so only the blocks from the
+// first changed one on need their entries.
+void	RangeIndex::update(const RateIndex& index, size_t from)
+{
+	const int*		dates = index.dates();
+	const Decimal*	rates = index.rates();
+	size_t			count = index.size();
+
+	_index = &index;
+	from = std::min(from, count);
+	if (_rateSums.size() < from + 1)
+		from = 0;
+	_rateSums.resize(count + 1, 0);
+	_timeSums.resize(count > 0 ? count : 1, 0);
+	_rateSums[0] = 0;
+	_timeSums[0] = 0;
+	for (size_t i = from > 0 ? from - 1 : 0; i < count; i++)
+	{
+		_rateSums[i + 1] = _rateSums[i] + rates[i];
+		if (i + 1 < count)
+			_timeSums[i + 1] = _timeSums[i]
+				+ static_cast<DecimalSum>(rates[i]) * (dates[i + 1] - dates[i]);
+	}
+
+	_blocks = (count + RANGE_BLOCK - 1) / RANGE_BLOCK;
+	size_t	levels = _blocks > 0 ? floorLog2(_blocks) + 1 : 0;
+	_blockMin.resize(levels);
+	_blockMax.resize(levels);
+	for (size_t k = 0; k < levels; k++)
+	{
+		_blockMin[k].resize(_blocks, 0);
+		_blockMax[k].resize(_blocks, 0);
+	}
+	for (size_t b = from / RANGE_BLOCK; b < _blocks; b++)
+	{
+		size_t	last = std::min(count, (b + 1) * RANGE_BLOCK) - 1;
+
+		scanExtremes(b * RANGE_BLOCK, last, _blockMin[0][b], _blockMax[0][b]);
+		for (size_t k = 1; k < levels && (static_cast<size_t>(1) << k) <= b + 1;
+			k++)
+		{
+			size_t	half = static_cast<size_t>(1) << (k - 1);
+
+			_blockMin[k][b] = std::min(_blockMin[k - 1][b],
+				_blockMin[k - 1][b - half]);
+			_blockMax[k][b] = std::max(_blockMax[k - 1][b],
+				_blockMax[k - 1][b - half]);
+		}
+	}
+}
+
+// Count, sum, mean, min and max of the rates dated from_day to to_day, and
+// the average of the rate in effect on each day of that range (days before
+// the first rate do not count).
+void	RangeIndex::query(int from_day, int to_day, RangeResult& result) const
+{
+	result.count = 0;
+	result.sum = 0;
+	result.min = 0;
+	result.max = 0;
+	result.mean = 0;
+	result.timed = false;
+	result.twap = 0;
+	if (!_index || _index->empty() || from_day > to_day)
+		return ;
+
+	const int*	dates = _index->dates();
+	size_t		size = _index->size();
+	size_t		first = static_cast<size_t>(std::lower_bound(dates,
+		dates + size, from_day) - dates);
+	size_t		end = static_cast<size_t>(std::upper_bound(dates + first,
+		dates + size, to_day) - dates);
+
+	if (end > first)
+	{
+		result.count = end - first;
+		result.sum = _rateSums[end] - _rateSums[first];
+		result.mean = divideSum(result.sum, result.count);
+
+		size_t	first_block = first / RANGE_BLOCK;
+		size_t	last_block = (end - 1) / RANGE_BLOCK;
+		if (last_block - first_block < 2)
+			scanExtremes(first, end - 1, result.min, result.max);
+		else
+		{
+			Decimal	min, max;
+
+			scanExtremes(first, (first_block + 1) * RANGE_BLOCK - 1,
+				result.min, result.max);
+			scanExtremes(last_block * RANGE_BLOCK, end - 1, min, max);
+
+			size_t	inner = last_block - first_block - 1;
+			size_t	k = floorLog2(inner);
+			size_t	left = first_block + (static_cast<size_t>(1) << k);
+			size_t	right = last_block - 1;
+
+			min = std::min(min, std::min(_blockMin[k][left], _blockMin[k][right]));
+			max = std::max(max, std::max(_blockMax[k][left], _blockMax[k][right]));
+			result.min = std::min(result.min, min);
+			result.max = std::max(result.max, max);
+		}
+	}
+
+	int	start = std::max(from_day, dates[0]);
+	if (to_day >= start)
+	{
+		int	days = to_day + 1 - start;
+
+		result.timed = true;
+		result.twap = divideSum(timeIntegral(to_day + 1) - timeIntegral(start),
+			static_cast<uint64_t>(days));
+	}
+}
+
+size_t	RangeIndex::memoryUsage() const
+{
+	size_t	blocks = 0;
+
+	for (size_t k = 0; k < _blockMin.size(); k++)
+		blocks += _blockMin[k].capacity() + _blockMax[k].capacity();
+	return ((_rateSums.capacity() + _timeSums.capacity()) * sizeof(DecimalSum)
+		+ blocks * sizeof(Decimal));
+}
+
+// sum of the rate in effect on each day from the first date up to day
+// (excluded)
+DecimalSum	RangeIndex::timeIntegral(int day) const
+{
+	const int*	dates = _index->dates();
+
+	if (day <= dates[0])
+		return (0);
+
+	long	pos = _index->lookup(day - 1);
+	return (_timeSums[static_cast<size_t>(pos)]
+		+ static_cast<DecimalSum>(_index->rateAt(static_cast<size_t>(pos)))
+		* (day - dates[pos]));
+}
+
+void	RangeIndex::scanExtremes(size_t first, size_t last, Decimal& min,
+			Decimal& max) const
+{
+	const Decimal*	rates = _index->rates();
+
+	min = rates[first];
+	max = rates[first];
+	for (size_t i = first + 1; i <= last; i++)
+	{
+		min = std::min(min, rates[i]);
+		max = std::max(max, rates[i]);
+	}
+}
+
+
+
+
+
+// --- helper functions definition ---
+static size_t	floorLog2(size_t value)
+{
+	size_t	log = 0;
+
+	while (value >>= 1)
+		log++;
+	return (log);
+}
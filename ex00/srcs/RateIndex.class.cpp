@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <cstring>
+
+#include "RateIndex.class.hpp"
+
+// --- helper functions declaration ---
+static bool	correctionLess(const RateIndex::Correction& a,
+				const RateIndex::Correction& b);
+
+// --- constructors / destructor ---
+RateIndex::RateIndex()
+	: _denseBudget(0), _dirtyFrom(NO_POS), _datePtr(NULL), _ratePtr(NULL),
+	_count(0), _mapping(NULL), _borrowed(false)
+{
+
+}
+
+RateIndex::~RateIndex()
+{
+	delete _mapping;
+}
+
+RateIndex::Cursor::Cursor()
+	: pos(NO_RATE), day(0), index(NULL)
+{
+	std::memset(&stats, 0, sizeof(stats));
+}
+
+
+
+
+
+// --- methods ---
+// amortized O(1) for rows in date order; older rows wait for finalize()
+void	RateIndex::insert(int day, Decimal rate)
+{
+	materialize();
+	if (!_dates.empty() && day <= _dates.back())
+	{
+		// same date twice in a row: the later row wins, like map[date] = rate
+		if (day == _dates.back())
+		{
+			_rates.back() = rate;
+			_dirtyFrom = std::min(_dirtyFrom, _dates.size() - 1);
+			return ;
+		}
+
+		Correction	row;
+
+		row.day = day;
+		row.rate = rate;
+		_corrections.push_back(row);
+		return ;
+	}
+	_dirtyFrom = std::min(_dirtyFrom, _dates.size());
+	_dates.push_back(day);
+	_rates.push_back(rate);
+	syncView();
+}
+
+// Merges queued corrections, keeping the last rate seen for each date, and
+// brings the dense table (if any) up to date from the first changed row.
+size_t	RateIndex::finalize()
+{
+	size_t	changed;
+
+	if (!_corrections.empty())
+		mergeCorrections();
+	if (_denseBudget && _dirtyFrom != NO_POS)
+		fillDenseTable(_dirtyFrom);
+	changed = _dirtyFrom;
+	_dirtyFrom = NO_POS;
+	return (changed);
+}
+
+// Serves lookups straight from already sorted arrays owned by mapping,
+// which the index then keeps alive and releases. With no mapping the
+// arrays belong to the caller and must outlive the index.
+void	RateIndex::attach(const int* dates, const Decimal* rates, size_t count,
+			MappedFile* mapping)
+{
+	std::vector<int>().swap(_dates);
+	std::vector<Decimal>().swap(_rates);
+	_corrections.clear();
+	_dense.clear();
+	_denseBudget = 0;
+	_dirtyFrom = NO_POS;
+	delete _mapping;
+
+	_datePtr = dates;
+	_ratePtr = rates;
+	_count = count;
+	_mapping = mapping;
+	_borrowed = true;
+}
+
+// Dense mode: one slot per calendar day between the first and last date,
+// each holding the position of the latest rate at or before that day, so a
+// lookup is a subtraction and a load. Refused when the range does not fit
+// budget_bytes; lookups then keep using the searched index.
+bool	RateIndex::buildDenseTable(size_t budget_bytes)
+{
+	_denseBudget = budget_bytes;
+	_dense.clear();
+	return (fillDenseTable(0));
+}
+
+bool	RateIndex::isDense() const
+{
+	return (!_dense.empty());
+}
+
+// position of the closest date at or before day, NO_RATE if there is none.
+// branch-free upper_bound: the loop body compiles to a conditional move.
+long	RateIndex::lookup(int day) const
+{
+	if (_count == 0)
+		return (NO_RATE);
+
+	if (!_dense.empty())
+	{
+		if (day < _datePtr[0])
+			return (NO_RATE);
+		if (day >= _datePtr[_count - 1])
+			return (static_cast<long>(_count) - 1);
+		return (_dense[day - _datePtr[0]]);
+	}
+
+	const int*	base = _datePtr;
+	size_t		len = _count;
+
+	while (len > 1)
+	{
+		size_t	half = len / 2;
+
+		base = (base[half] <= day) ? base + half : base;
+		len -= half;
+	}
+
+	return (static_cast<long>(base - _datePtr) + (*base <= day) - 1);
+}
+
+// Lookup for input that is sorted or nearly so: while query dates keep
+// rising, the answer is found by walking forward from the previous one,
+// which touches the date array sequentially. Out-of-order queries, long
+// gaps (more than MERGE_WALK_MAX rows) and dense mode go through lookup().
+long	RateIndex::lookup(int day, Cursor& cursor) const
+{
+	if (!_dense.empty())
+	{
+		cursor.stats.direct++;
+		return (lookup(day));
+	}
+
+	if (cursor.index == this && day >= cursor.day)
+	{
+		long	pos = cursor.pos;
+		long	last = static_cast<long>(_count) - 1;
+		int		steps = 0;
+
+		while (pos < last && _datePtr[pos + 1] <= day && steps < MERGE_WALK_MAX)
+		{
+			pos++;
+			steps++;
+		}
+		if (pos == last || _datePtr[pos + 1] > day)
+		{
+			cursor.pos = pos;
+			cursor.day = day;
+			cursor.stats.merged++;
+			return (pos);
+		}
+	}
+
+	cursor.pos = lookup(day);
+	cursor.day = day;
+	cursor.index = this;
+	cursor.stats.searched++;
+	return (cursor.pos);
+}
+
+size_t	RateIndex::size() const
+{
+	return (_count);
+}
+
+bool	RateIndex::empty() const
+{
+	return (_count == 0);
+}
+
+int	RateIndex::dateAt(size_t pos) const
+{
+	return (_datePtr[pos]);
+}
+
+Decimal	RateIndex::rateAt(size_t pos) const
+{
+	return (_ratePtr[pos]);
+}
+
+const int*	RateIndex::dates() const
+{
+	return (_datePtr);
+}
+
+const Decimal*	RateIndex::rates() const
+{
+	return (_ratePtr);
+}
+
+bool	RateIndex::isMapped() const
+{
+	return (_mapping != NULL);
+}
+
+// bytes of the rows served (owned or borrowed) plus the dense table
+size_t	RateIndex::memoryUsage() const
+{
+	return (_count * (sizeof(int) + sizeof(Decimal))
+		+ _dense.capacity() * sizeof(int));
+}
+
+// Corrections are sorted by date (stable, so the last row for a date wins)
+// and merged backwards into the arrays: only rows from the first corrected
+// date onward move.
+void	RateIndex::mergeCorrections()
+{
+	std::stable_sort(_corrections.begin(), _corrections.end(), correctionLess);
+
+	size_t	unique = 0;
+	size_t	added = 0;
+	for (size_t i = 0; i < _corrections.size(); i++)
+	{
+		if (i + 1 < _corrections.size()
+			&& _corrections[i + 1].day == _corrections[i].day)
+			continue;
+		_corrections[unique++] = _corrections[i];
+		if (!std::binary_search(_dates.begin(), _dates.end(),
+				_corrections[unique - 1].day))
+			added++;
+	}
+	_corrections.resize(unique);
+
+	size_t	first = static_cast<size_t>(std::lower_bound(_dates.begin(),
+		_dates.end(), _corrections[0].day) - _dates.begin());
+	size_t	old_count = _dates.size();
+	_dates.resize(old_count + added);
+	_rates.resize(old_count + added);
+
+	size_t	src = old_count;
+	size_t	fix = unique;
+	size_t	dst = old_count + added;
+	while (fix > 0)
+	{
+		const Correction&	row = _corrections[fix - 1];
+
+		dst--;
+		if (src > first && _dates[src - 1] > row.day)
+		{
+			src--;
+			_dates[dst] = _dates[src];
+			_rates[dst] = _rates[src];
+			continue;
+		}
+		if (src > first && _dates[src - 1] == row.day)
+			src--;
+		_dates[dst] = row.day;
+		_rates[dst] = row.rate;
+		fix--;
+	}
+
+	_corrections.clear();
+	_dirtyFrom = std::min(_dirtyFrom, first);
+	syncView();
+}
+
+// (re)computes the dense slots from the row before from_pos to the last
+// date; slots before that row are still valid since it did not move
+bool	RateIndex::fillDenseTable(size_t from_pos)
+{
+	if (_count == 0)
+	{
+		_dense.clear();
+		return (false);
+	}
+
+	int		first = _datePtr[0];
+	size_t	span = static_cast<size_t>(_datePtr[_count - 1] - first) + 1;
+	if (span > _denseBudget / sizeof(int))
+	{
+		_dense.clear();
+		return (false);
+	}
+	if (_dense.empty())
+		from_pos = 0;
+	else if (from_pos > 0)
+		from_pos--;
+
+	_dense.resize(span);
+	size_t	pos = from_pos;
+	for (size_t offset = static_cast<size_t>(_datePtr[from_pos] - first);
+		offset < span; offset++)
+	{
+		int	day = first + static_cast<int>(offset);
+
+		while (pos + 1 < _count && _datePtr[pos + 1] <= day)
+			pos++;
+		_dense[offset] = static_cast<int>(pos);
+	}
+	return (true);
+}
+
+// copies borrowed arrays into owned storage before they get modified
+void	RateIndex::materialize()
+{
+	if (!_borrowed)
+		return ;
+
+	_dates.assign(_datePtr, _datePtr + _count);
+	_rates.assign(_ratePtr, _ratePtr + _count);
+	delete _mapping;
+	_mapping = NULL;
+	_borrowed = false;
+	syncView();
+}
+
+void	RateIndex::syncView()
+{
+	_count = _dates.size();
+	_datePtr = _dates.empty() ? NULL : &_dates[0];
+	_ratePtr = _rates.empty() ? NULL : &_rates[0];
+}
+
+
+
+
+
+void	addLookupStats(LookupStats& total, const LookupStats& part)
+{
+	total.merged += part.merged;
+	total.searched += part.searched;
+	total.direct += part.direct;
+}
+
+
+
+
+
+// --- helper functions definition ---
+static bool	correctionLess(const RateIndex::Correction& a,
+				const RateIndex::Correction& b)
+{
+	return (a.day < b.day);
+}
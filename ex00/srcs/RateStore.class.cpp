@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <cstring>
+
+#include "MappedFile.class.hpp"
+#include "RateStore.class.hpp"
+#include "snapshot.hpp"
+
+// --- helper functions declaration ---
+static bool	seriesLess(const RateStore::Series& a, const RateStore::Series& b);
+static int	compareName(const std::string& name, const char* str, size_t len);
+
+// --- constructors / destructor ---
+RateStore::RateStore()
+	: _sealed(false)
+{
+
+}
+
+RateStore::~RateStore()
+{
+	for (size_t i = 0; i < _series.size(); i++)
+	{
+		if (_series[i].external)
+			continue;
+		delete _series[i].ranges;
+		delete _series[i].index;
+	}
+}
+
+
+
+
+
+// --- methods ---
+// one series from a "date,exchange_rate" file; a symbol appears only once
+bool	RateStore::loadFile(const std::string& name, const char* path,
+			bool use_snapshot)
+{
+	if (_sealed || !isSymbolName(name.data(), name.size())
+		|| find(name.data(), name.size()))
+		return (false);
+
+	Series*	series = add(name, false);
+	if (!loadDatabaseFile(path, use_snapshot, *series->index, series->report))
+	{
+		delete series->ranges;
+		delete series->index;
+		_series.pop_back();
+		return (false);
+	}
+	return (true);
+}
+
+// Rows of a "symbol,date,exchange_rate" table go to their symbol's series;
+// symbols may interleave. Bad rows, bad symbols and rows for a symbol
+// listed with addExternal() are skipped.
+bool	RateStore::loadTable(const char* path, LoadReport& report)
+{
+	MappedFile	file;
+	double		start = monotonicSeconds();
+
+	if (_sealed || !file.open(path))
+		return (false);
+
+	const char*	cur = file.data();
+	const char*	end = cur + file.size();
+	size_t		header_len = std::strlen(TABLE_HEADER);
+	Series*		last = NULL;
+
+	while (cur < end)
+	{
+		const char*	eol = static_cast<const char*>(std::memchr(cur, '\n',
+				static_cast<size_t>(end - cur)));
+		const char*	line_end = eol ? eol : end;
+		size_t		line_len = static_cast<size_t>(line_end - cur);
+
+		if (!(line_len == header_len && !std::memcmp(cur, TABLE_HEADER, header_len)))
+		{
+			const char*	comma = static_cast<const char*>(std::memchr(cur, ',',
+					line_len));
+			size_t		len = comma ? static_cast<size_t>(comma - cur) : 0;
+			int			day;
+			Decimal		rate;
+
+			// rows of one symbol usually come in runs
+			if (comma && isSymbolName(cur, len)
+				&& (!last || compareName(last->name, cur, len) != 0))
+			{
+				last = const_cast<Series*>(find(cur, len));
+				if (!last)
+					last = add(std::string(cur, len), false);
+			}
+
+			if (!comma || !isSymbolName(cur, len) || last->external
+				|| !parseRateRow(comma + 1, line_end, day, rate))
+				report.skipped++;
+			else
+			{
+				last->index->insert(day, rate);
+				last->report.rows++;
+				report.rows++;
+			}
+		}
+		cur = eol ? eol + 1 : end;
+	}
+
+	for (size_t i = 0; i < _series.size(); i++)
+	{
+		if (!_series[i].external)
+			_series[i].index->finalize();
+	}
+	report.bytes += file.size();
+	report.seconds += monotonicSeconds() - start;
+	return (true);
+}
+
+// lists an index owned elsewhere (the default series) under name
+bool	RateStore::addExternal(const std::string& name, RateIndex& index,
+			RangeIndex& ranges)
+{
+	if (_sealed || find(name.data(), name.size()))
+		return (false);
+
+	Series*	series = add(name, true);
+	delete series->ranges;
+	delete series->index;
+	series->index = &index;
+	series->ranges = &ranges;
+	return (true);
+}
+
+// Copies every owned series into the shared arena, points its index at
+// its slice, builds its range index and sorts the symbol table.
+void	RateStore::seal()
+{
+	size_t	total = 0;
+
+	for (size_t i = 0; i < _series.size(); i++)
+	{
+		if (!_series[i].external)
+			total += _series[i].index->size();
+	}
+	_dates.resize(total);
+	_rates.resize(total);
+
+	size_t	offset = 0;
+	for (size_t i = 0; i < _series.size(); i++)
+	{
+		Series&	series = _series[i];
+		size_t	count = series.index->size();
+
+		if (series.external)
+			continue;
+		if (count > 0)
+		{
+			std::memcpy(&_dates[offset], series.index->dates(), count * sizeof(int));
+			std::memcpy(&_rates[offset], series.index->rates(),
+				count * sizeof(Decimal));
+			series.index->attach(&_dates[offset], &_rates[offset], count, NULL);
+		}
+		series.ranges->build(*series.index);
+		offset += count;
+	}
+
+	std::sort(_series.begin(), _series.end(), seriesLess);
+	_sealed = true;
+}
+
+void	RateStore::buildDenseTables(size_t budget_bytes)
+{
+	for (size_t i = 0; i < _series.size(); i++)
+	{
+		if (!_series[i].external)
+			_series[i].index->buildDenseTable(budget_bytes);
+	}
+}
+
+// binary search by name once sealed, linear while loading
+const RateStore::Series*	RateStore::find(const char* name, size_t len) const
+{
+	if (!_sealed)
+	{
+		for (size_t i = 0; i < _series.size(); i++)
+		{
+			if (compareName(_series[i].name, name, len) == 0)
+				return (&_series[i]);
+		}
+		return (NULL);
+	}
+
+	size_t	low = 0;
+	size_t	high = _series.size();
+	while (low < high)
+	{
+		size_t	mid = (low + high) / 2;
+		int		cmp = compareName(_series[mid].name, name, len);
+
+		if (cmp == 0)
+			return (&_series[mid]);
+		if (cmp < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return (NULL);
+}
+
+size_t	RateStore::size() const
+{
+	return (_series.size());
+}
+
+const RateStore::Series&	RateStore::at(size_t pos) const
+{
+	return (_series[pos]);
+}
+
+// the series' share of the arena plus its dense and range tables
+size_t	RateStore::memoryUsage(size_t pos) const
+{
+	return (_series[pos].index->memoryUsage()
+		+ _series[pos].ranges->memoryUsage());
+}
+
+RateStore::Series*	RateStore::add(const std::string& name, bool external)
+{
+	Series	series;
+
+	series.name = name;
+	series.index = new RateIndex();
+	series.ranges = new RangeIndex();
+	std::memset(&series.report, 0, sizeof(series.report));
+	series.external = external;
+	_series.push_back(series);
+	return (&_series.back());
+}
+
+
+
+
+
+// --- helper functions definition ---
+static bool	seriesLess(const RateStore::Series& a, const RateStore::Series& b)
+{
+	return (a.name < b.name);
+}
+
+static int	compareName(const std::string& name, const char* str, size_t len)
+{
+	int	cmp = std::memcmp(name.data(), str, std::min(name.size(), len));
+
+	if (cmp != 0)
+		return (cmp);
+	if (name.size() == len)
+		return (0);
+	return (name.size() < len ? -1 : 1);
+}
@@ -0,0 +1,482 @@
+#include <cstring>
+
+#include "colors.hpp"
+#include "dates.hpp"
+#include "ResultWriter.class.hpp"
+
+// --- helper functions declaration ---
+static const char*	rejectionName(LineStatus status);
+static void			appendUnsigned(OutputBuffer& buf, size_t value);
+static void			appendSymbol(OutputBuffer& buf, const char* symbol, size_t len);
+static void			appendCsvField(OutputBuffer& buf, const char* str, size_t len);
+static void			appendJsonString(OutputBuffer& buf, const char* str, size_t len);
+static void			appendOptional(OutputBuffer& buf, bool present, Decimal value,
+						const char* absent);
+
+// --- constructors / destructor ---
+ResultWriter::ResultWriter()
+	: _format(FORMAT_TEXT), _plain(false)
+{
+
+}
+
+ResultWriter::~ResultWriter()
+{
+
+}
+
+
+
+
+
+// --- methods ---
+void	ResultWriter::setFormat(OutputFormat format)
+{
+	_format = format;
+}
+
+void	ResultWriter::setPlain(bool plain)
+{
+	_plain = plain;
+}
+
+void	ResultWriter::writeStreamHeader(OutputBuffer& out) const
+{
+	if (_format == FORMAT_CSV)
+	{
+		out.append("line,symbol,date,amount,db_date,rate,value");
+		out.endLine();
+	}
+	else if (_format == FORMAT_BINARY)
+	{
+		RecordHeader	header;
+
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+		header.version = RECORD_VERSION;
+		header.record_size = sizeof(ConversionRecord);
+		out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+	}
+}
+
+void	ResultWriter::writeSeparator(OutputBuffer& out) const
+{
+	if (_format != FORMAT_TEXT || _plain)
+		return ;
+	out.append(" ------------------------------------------------------------ ");
+	out.endLine();
+}
+
+void	ResultWriter::writeConversion(OutputBuffer& out, const Conversion& conv) const
+{
+	char	db_date[DATE_LEN];
+
+	if (conv.matched)
+		formatDate(conv.db_day, db_date);
+
+	switch (_format)
+	{
+		case FORMAT_TEXT:
+			style(out, GREEN);
+			out.append(" Valid: ");
+			style(out, RESET);
+			writeTextSymbol(out, conv.symbol, conv.symbol_len);
+			out.append(conv.date, DATE_LEN);
+			out.append("  =>  ");
+			out.appendDecimal(conv.amount);
+			out.append(" (");
+			if (conv.matched)
+			{
+				out.appendDecimal(conv.rate);
+				out.append(" on ");
+				out.append(db_date, DATE_LEN);
+			}
+			else
+				out.append("no data");
+			out.append(") = ");
+			style(out, REVERSED " ");
+			out.appendDecimal(conv.value);
+			style(out, " " RESET);
+			out.endLine();
+			break;
+
+		case FORMAT_CSV:
+			appendUnsigned(out, conv.line);
+			out.append(',');
+			appendSymbol(out, conv.symbol, conv.symbol_len);
+			out.append(',');
+			out.append(conv.date, DATE_LEN);
+			out.append(',');
+			out.appendDecimal(conv.amount);
+			out.append(',');
+			if (conv.matched)
+				out.append(db_date, DATE_LEN);
+			out.append(',');
+			out.appendDecimal(conv.rate);
+			out.append(',');
+			out.appendDecimal(conv.value);
+			out.endLine();
+			break;
+
+		case FORMAT_NDJSON:
+			out.append("{\"line\":");
+			appendUnsigned(out, conv.line);
+			out.append(",\"symbol\":\"");
+			appendSymbol(out, conv.symbol, conv.symbol_len);
+			out.append("\",\"date\":\"");
+			out.append(conv.date, DATE_LEN);
+			out.append("\",\"amount\":");
+			out.appendDecimal(conv.amount);
+			out.append(",\"db_date\":");
+			if (conv.matched)
+			{
+				out.append('"');
+				out.append(db_date, DATE_LEN);
+				out.append('"');
+			}
+			else
+				out.append("null");
+			out.append(",\"rate\":");
+			out.appendDecimal(conv.rate);
+			out.append(",\"value\":");
+			out.appendDecimal(conv.value);
+			out.append('}');
+			out.endLine();
+			break;
+
+		case FORMAT_BINARY:
+		{
+			ConversionRecord	record;
+
+			std::memset(record.symbol, 0, sizeof(record.symbol));
+			if (conv.symbol_len)
+				std::memcpy(record.symbol, conv.symbol, conv.symbol_len);
+			else
+				std::memcpy(record.symbol, DEFAULT_SYMBOL,
+					std::strlen(DEFAULT_SYMBOL));
+			record.amount = conv.amount;
+			record.rate = conv.rate;
+			record.value = conv.value;
+			record.day = conv.day;
+			record.db_day = conv.matched ? conv.db_day : RECORD_NO_DATE;
+			record.line = static_cast<uint32_t>(conv.line);
+			record.reserved = 0;
+			out.append(reinterpret_cast<const char*>(&record), sizeof(record));
+			break;
+		}
+	}
+}
+
+void	ResultWriter::writeRange(OutputBuffer& out, OutputBuffer& err,
+			size_t line, const InputLine& input, const RangeResult& range) const
+{
+	char	from[DATE_LEN];
+	char	to[DATE_LEN];
+	bool	rows = (range.count > 0);
+
+	formatDate(input.day, from);
+	formatDate(input.to_day, to);
+	switch (_format)
+	{
+		case FORMAT_TEXT:
+			style(out, GREEN);
+			out.append(" Range: ");
+			style(out, RESET);
+			writeTextSymbol(out, input.symbol, input.symbol_len);
+			out.append(from, DATE_LEN);
+			out.append(" .. ");
+			out.append(to, DATE_LEN);
+			out.append("  =>  ");
+			if (!rows && !range.timed)
+				out.append("no data");
+			else
+			{
+				appendUnsigned(out, range.count);
+				out.append(" rates, min ");
+				appendOptional(out, rows, range.min, "-");
+				out.append(", max ");
+				appendOptional(out, rows, range.max, "-");
+				out.append(", mean ");
+				appendOptional(out, rows, range.mean, "-");
+				out.append(", twap ");
+				appendOptional(out, range.timed, range.twap, "-");
+			}
+			out.endLine();
+			break;
+
+		case FORMAT_CSV:
+			appendUnsigned(out, line);
+			out.append(',');
+			appendSymbol(out, input.symbol, input.symbol_len);
+			out.append(',');
+			out.append(from, DATE_LEN);
+			out.append(',');
+			out.append(to, DATE_LEN);
+			out.append(',');
+			appendUnsigned(out, range.count);
+			out.append(',');
+			appendOptional(out, rows, range.min, "");
+			out.append(',');
+			appendOptional(out, rows, range.max, "");
+			out.append(',');
+			appendOptional(out, rows, range.mean, "");
+			out.append(',');
+			appendOptional(out, range.timed, range.twap, "");
+			out.endLine();
+			break;
+
+		case FORMAT_NDJSON:
+		case FORMAT_BINARY:
+		{
+			OutputBuffer&	json = (_format == FORMAT_NDJSON) ? out : err;
+
+			json.append("{\"line\":");
+			appendUnsigned(json, line);
+			json.append(",\"symbol\":\"");
+			appendSymbol(json, input.symbol, input.symbol_len);
+			json.append("\",\"from\":\"");
+			json.append(from, DATE_LEN);
+			json.append("\",\"to\":\"");
+			json.append(to, DATE_LEN);
+			json.append("\",\"count\":");
+			appendUnsigned(json, range.count);
+			json.append(",\"min\":");
+			appendOptional(json, rows, range.min, "null");
+			json.append(",\"max\":");
+			appendOptional(json, rows, range.max, "null");
+			json.append(",\"mean\":");
+			appendOptional(json, rows, range.mean, "null");
+			json.append(",\"twap\":");
+			appendOptional(json, range.timed, range.twap, "null");
+			json.append('}');
+			json.endLine();
+			break;
+		}
+	}
+}
+
+void	ResultWriter::writeMissingHeader(OutputBuffer& err) const
+{
+	if (_format == FORMAT_TEXT)
+	{
+		style(err, RED);
+		err.append(" Error:");
+		style(err, RESET);
+		err.append(" missing header => date | value");
+		err.endLine();
+	}
+	else if (_format == FORMAT_CSV)
+	{
+		err.append("1,missing header,");
+		err.endLine();
+	}
+	else
+	{
+		err.append("{\"line\":1,\"error\":\"missing header\"}");
+		err.endLine();
+	}
+}
+
+void	ResultWriter::writeRejection(OutputBuffer& err, size_t line,
+			LineStatus status, const char* token, size_t len) const
+{
+	if (_format == FORMAT_TEXT)
+	{
+		if (status == LINE_BAD_LINE && len == 0)
+			writeTextError(err, " bad line    =>  ", "(empty)", 7);
+		else if (status == LINE_BAD_LINE)
+			writeTextError(err, " bad line    =>  ", token, len);
+		else if (status == LINE_BAD_DATE)
+			writeTextError(err, " bad date    =>  ", token, len);
+		else if (status == LINE_BAD_VALUE)
+			writeTextError(err, " bad value   =>  ", token, len);
+		else if (status == LINE_BAD_SYMBOL)
+			writeTextError(err, " bad symbol  =>  ", token, len);
+		else
+			writeTextError(err, " too large   =>  ", token, len);
+	}
+	else if (_format == FORMAT_CSV)
+	{
+		appendUnsigned(err, line);
+		err.append(',');
+		err.append(rejectionName(status));
+		err.append(',');
+		appendCsvField(err, token, len);
+		err.endLine();
+	}
+	else
+	{
+		err.append("{\"line\":");
+		appendUnsigned(err, line);
+		err.append(",\"error\":\"");
+		err.append(rejectionName(status));
+		err.append("\",\"input\":");
+		appendJsonString(err, token, len);
+		err.append('}');
+		err.endLine();
+	}
+}
+
+void	ResultWriter::style(OutputBuffer& buf, const char* code) const
+{
+	if (!_plain)
+		buf.append(code);
+}
+
+void	ResultWriter::writeTextError(OutputBuffer& err, const char* what,
+			const char* token, size_t len) const
+{
+	style(err, RED);
+	err.append(" Error:");
+	style(err, RESET);
+	err.append(what);
+	style(err, ORANGE);
+	err.append(token, len);
+	style(err, RESET);
+	err.endLine();
+}
+
+// the symbol a line named, then a space; nothing for the default database
+void	ResultWriter::writeTextSymbol(OutputBuffer& out, const char* symbol,
+			size_t len) const
+{
+	if (!len)
+		return ;
+	style(out, BLUE);
+	out.append(symbol, len);
+	style(out, RESET);
+	out.append(' ');
+}
+
+bool	parseOutputFormat(const char* name, OutputFormat& format)
+{
+	if (!std::strcmp(name, "text"))
+		format = FORMAT_TEXT;
+	else if (!std::strcmp(name, "csv"))
+		format = FORMAT_CSV;
+	else if (!std::strcmp(name, "ndjson"))
+		format = FORMAT_NDJSON;
+	else if (!std::strcmp(name, "binary"))
+		format = FORMAT_BINARY;
+	else
+		return (false);
+	return (true);
+}
+
+
+// Looks up an accepted input line and fills in everything a record needs;
+// false when amount * rate does not fit a Decimal.
+bool	resolveConversion(const RateIndex& index, RateIndex::Cursor& cursor,
+			size_t line_no, const InputLine& line, Conversion& conv)
+{
+	long	pos = index.lookup(line.day, cursor);
+
+	conv.line = line_no;
+	conv.symbol = line.symbol;
+	conv.symbol_len = line.symbol_len;
+	conv.date = line.token;
+	conv.day = line.day;
+	conv.amount = line.value;
+	conv.matched = (pos != NO_RATE);
+	conv.db_day = conv.matched ? index.dateAt(pos) : 0;
+	conv.rate = conv.matched ? index.rateAt(pos) : 0;
+	return (mulDecimal(conv.rate, line.value, conv.value));
+}
+
+
+
+
+
+// --- helper functions definition ---
+static const char*	rejectionName(LineStatus status)
+{
+	if (status == LINE_BAD_DATE)
+		return ("bad date");
+	if (status == LINE_BAD_VALUE)
+		return ("bad value");
+	if (status == LINE_TOO_LARGE)
+		return ("too large");
+	if (status == LINE_BAD_SYMBOL)
+		return ("bad symbol");
+	return ("bad line");
+}
+
+static void	appendUnsigned(OutputBuffer& buf, size_t value)
+{
+	char	digits[24];
+	size_t	len = 0;
+
+	do
+	{
+		digits[sizeof(digits) - ++len] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value > 0);
+	buf.append(digits + sizeof(digits) - len, len);
+}
+
+// the symbol a machine-readable record names: DEFAULT_SYMBOL for a line
+// answered by the default database
+static void	appendSymbol(OutputBuffer& buf, const char* symbol, size_t len)
+{
+	if (len)
+		buf.append(symbol, len);
+	else
+		buf.append(DEFAULT_SYMBOL);
+}
+
+// RFC 4180: quoted only when needed, quotes doubled
+static void	appendCsvField(OutputBuffer& buf, const char* str, size_t len)
+{
+	bool	quote = false;
+
+	for (size_t i = 0; i < len && !quote; i++)
+		quote = (str[i] == ',' || str[i] == '"' || str[i] == '\r' || str[i] == '\n');
+	if (!quote)
+	{
+		buf.append(str, len);
+		return ;
+	}
+	buf.append('"');
+	for (size_t i = 0; i < len; i++)
+	{
+		if (str[i] == '"')
+			buf.append('"');
+		buf.append(str[i]);
+	}
+	buf.append('"');
+}
+
+static void	appendJsonString(OutputBuffer& buf, const char* str, size_t len)
+{
+	static const char	hex[] = "0123456789abcdef";
+
+	buf.append('"');
+	for (size_t i = 0; i < len; i++)
+	{
+		unsigned char	c = static_cast<unsigned char>(str[i]);
+
+		if (c == '"' || c == '\\')
+		{
+			buf.append('\\');
+			buf.append(static_cast<char>(c));
+		}
+		else if (c < 0x20)
+		{
+			buf.append("\\u00");
+			buf.append(hex[c >> 4]);
+			buf.append(hex[c & 0xf]);
+		}
+		else
+			buf.append(static_cast<char>(c));
+	}
+	buf.append('"');
+}
+
+static void	appendOptional(OutputBuffer& buf, bool present, Decimal value,
+				const char* absent)
+{
+	if (present)
+		buf.appendDecimal(value);
+	else
+		buf.append(absent);
+}
@@ -0,0 +1,99 @@
+#include "WorkerPool.class.hpp"
+
+// --- constructors / destructor ---
+WorkerPool::WorkerPool(size_t threads)
+	: _task(NULL), _args(NULL), _count(0), _next(0), _pending(0), _stop(false)
+{
+	pthread_mutex_init(&_mutex, NULL);
+	pthread_cond_init(&_wake, NULL);
+	pthread_cond_init(&_done, NULL);
+
+	for (size_t i = 0; i < threads; i++)
+	{
+		pthread_t	thread;
+
+		if (pthread_create(&thread, NULL, workerMain, this) != 0)
+			break;
+		_threads.push_back(thread);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	pthread_mutex_lock(&_mutex);
+	_stop = true;
+	pthread_cond_broadcast(&_wake);
+	pthread_mutex_unlock(&_mutex);
+
+	for (size_t i = 0; i < _threads.size(); i++)
+		pthread_join(_threads[i], NULL);
+
+	pthread_cond_destroy(&_done);
+	pthread_cond_destroy(&_wake);
+	pthread_mutex_destroy(&_mutex);
+}
+
+
+
+
+
+// --- methods ---
+// Runs task(args[i]) for every i and returns once all of them finished.
+// Falls back to the calling thread if no worker could be started.
+void	WorkerPool::run(Task task, void** args, size_t count)
+{
+	if (_threads.empty())
+	{
+		for (size_t i = 0; i < count; i++)
+			task(args[i]);
+		return ;
+	}
+
+	pthread_mutex_lock(&_mutex);
+	_task = task;
+	_args = args;
+	_count = count;
+	_next = 0;
+	_pending = count;
+	pthread_cond_broadcast(&_wake);
+	while (_pending > 0)
+		pthread_cond_wait(&_done, &_mutex);
+	_count = 0;
+	_next = 0;
+	pthread_mutex_unlock(&_mutex);
+}
+
+size_t	WorkerPool::size() const
+{
+	return (_threads.size());
+}
+
+void*	WorkerPool::workerMain(void* arg)
+{
+	static_cast<WorkerPool*>(arg)->workerLoop();
+	return (NULL);
+}
+
+void	WorkerPool::workerLoop()
+{
+	pthread_mutex_lock(&_mutex);
+	while (true)
+	{
+		while (!_stop && _next >= _count)
+			pthread_cond_wait(&_wake, &_mutex);
+		if (_stop)
+			break;
+
+		size_t	i = _next++;
+		Task	task = _task;
+		void*	arg = _args[i];
+
+		pthread_mutex_unlock(&_mutex);
+		task(arg);
+		pthread_mutex_lock(&_mutex);
+
+		if (--_pending == 0)
+			pthread_cond_signal(&_done);
+	}
+	pthread_mutex_unlock(&_mutex);
+}
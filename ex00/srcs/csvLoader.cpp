@@ -0,0 +1,98 @@
+#include <cstring>
+#include <ctime>
+
+#include "csvLoader.hpp"
+#include "dates.hpp"
+#include "MappedFile.class.hpp"
+#include "scanners.hpp"
+
+// --- loader ---
+// Parses every complete line of data in place, without copying it: rows
+// are "YYYY-MM-DD,rate" and the same rows the getline loader used to
+// drop (header, short lines, missing comma, bad date, no number) are
+// skipped. Returns the number of bytes consumed.
+size_t	parseRateCsv(const char* data, size_t len, RateIndex& index,
+			LoadReport& report)
+{
+	const char*	cur = data;
+	const char*	end = data + len;
+	size_t		header_len = std::strlen(DB_HEADER);
+
+	while (cur < end)
+	{
+		const char*	eol = static_cast<const char*>(std::memchr(cur, '\n',
+				static_cast<size_t>(end - cur)));
+		const char*	line_end = eol ? eol : end;
+		size_t		line_len = static_cast<size_t>(line_end - cur);
+
+		if (!(line_len == header_len && !std::memcmp(cur, DB_HEADER, header_len)))
+		{
+			int		day;
+			Decimal	rate;
+
+			if (parseRateRow(cur, line_end, day, rate))
+			{
+				index.insert(day, rate);
+				report.rows++;
+			}
+			else
+				report.skipped++;
+		}
+		cur = eol ? eol + 1 : end;
+	}
+
+	report.bytes += static_cast<size_t>(cur - data);
+	return (static_cast<size_t>(cur - data));
+}
+
+bool	loadRateCsv(const char* path, RateIndex& index, LoadReport& report)
+{
+	MappedFile	file;
+	double		start = monotonicSeconds();
+
+	if (!file.open(path))
+		return (false);
+
+	parseRateCsv(file.data(), file.size(), index, report);
+	report.source_size = file.size();
+	index.finalize();
+
+	report.seconds += monotonicSeconds() - start;
+	return (true);
+}
+
+// one "YYYY-MM-DD,rate" row, blanks allowed before the rate
+bool	parseRateRow(const char* line, const char* end, int& day, Decimal& rate)
+{
+	int	year, month, mday;
+
+	if (end - line <= DATE_LEN + 1 || line[DATE_LEN] != ',')
+		return (false);
+	if (!parseDate(line, year, month, mday))
+		return (false);
+
+	const char*	cur = line + DATE_LEN + 1;
+	while (cur < end && isBlank(*cur))
+		cur++;
+	if (!scanDecimal(cur, end, rate))
+		return (false);
+
+	day = daysFromCivil(year, month, mday);
+	return (true);
+}
+
+double	rowsPerSecond(const LoadReport& report)
+{
+	if (report.seconds <= 0.0)
+		return (0.0);
+	return (static_cast<double>(report.rows) / report.seconds);
+}
+
+double	monotonicSeconds()
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (static_cast<double>(ts.tv_sec)
+		+ static_cast<double>(ts.tv_nsec) / 1e9);
+}
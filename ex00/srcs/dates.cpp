@@ -0,0 +1,268 @@
+#include <cstring>
+#include <stdint.h>
+
+#include "dates.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define DATES_SSSE3
+# include <tmmintrin.h>
+#endif
+
+typedef bool	(*DateParser)(const char* str, int& year, int& month, int& day);
+
+// --- helper functions declaration ---
+static bool			parseDateScalar(const char* str, int& year, int& month,
+						int& day);
+static bool			parseDatePrefixScalar(const char* str, int& year,
+						int& month, int& day);
+static DateParser	selectDateParser(bool prefix);
+#ifdef DATES_SSSE3
+static bool			parseDateSsse3(const char* str, int& year, int& month,
+						int& day);
+static bool			parseDatePrefixSsse3(const char* str, int& year,
+						int& month, int& day);
+static bool			matchShapeSsse3(__m128i text, __m128i digit_lanes,
+						__m128i literals, int lanes);
+static bool			foldDateSsse3(__m128i text, int& year, int& month,
+						int& day);
+#endif
+
+// picked once, before main, from what the running CPU supports
+static const DateParser	g_parse_date = selectDateParser(false);
+static const DateParser	g_parse_date_prefix = selectDateParser(true);
+
+// --- calendar rules ---
+bool	isLeapYear(int year)
+{
+	return (year % 400 == 0 || (year % 4 == 0 && year % 100 != 0));
+}
+
+bool	dayIsInvalid(int day, int month, int year)
+{
+	if (day < 1 || day > 31)
+		return (true);
+
+	// february
+	if (month == 2)
+	{
+		if (isLeapYear(year))
+		{
+			// leap year
+			if (day > 29)
+				return (true);
+		}
+		else if (day > 28)
+			return (true);
+	}
+	// april, june, september, november
+	else if ((month == 4 || month == 6 || month == 9 || month == 11)
+			&& day > 30)
+		return (true);
+
+	return (false);
+}
+
+
+
+
+
+// --- parsing / formatting ---
+// expects exactly "YYYY-MM-DD" in the first DATE_LEN bytes of str
+bool	parseDate(const char* str, int& year, int& month, int& day)
+{
+	return (g_parse_date(str, year, month, day));
+}
+
+// expects "YYYY-MM-DD | d", d a digit, in the first DATE_PREFIX_LEN bytes
+// of str: the fixed-width start of a well-formed input line
+bool	parseDatePrefix(const char* str, int& year, int& month, int& day)
+{
+	return (g_parse_date_prefix(str, year, month, day));
+}
+
+// days since 1970-01-01 in the proleptic gregorian calendar
+int	daysFromCivil(int year, int month, int day)
+{
+	year -= (month <= 2);
+
+	int	era = (year >= 0 ? year : year - 399) / 400;
+	int	yoe = year - era * 400;
+	int	doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	int	doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+	return (era * 146097 + doe - 719468);
+}
+
+void	civilFromDays(int days, int& year, int& month, int& day)
+{
+	days += 719468;
+
+	int	era = (days >= 0 ? days : days - 146096) / 146097;
+	int	doe = days - era * 146097;
+	int	yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	int	doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	int	mp = (5 * doy + 2) / 153;
+
+	day = doy - (153 * mp + 2) / 5 + 1;
+	month = mp + (mp < 10 ? 3 : -9);
+	year = yoe + era * 400 + (month <= 2);
+}
+
+// writes "YYYY-MM-DD" (no terminator) into out
+void	formatDate(int days, char* out)
+{
+	int	year, month, day;
+
+	civilFromDays(days, year, month, day);
+	out[0] = static_cast<char>('0' + year / 1000 % 10);
+	out[1] = static_cast<char>('0' + year / 100 % 10);
+	out[2] = static_cast<char>('0' + year / 10 % 10);
+	out[3] = static_cast<char>('0' + year % 10);
+	out[4] = '-';
+	out[5] = static_cast<char>('0' + month / 10);
+	out[6] = static_cast<char>('0' + month % 10);
+	out[7] = '-';
+	out[8] = static_cast<char>('0' + day / 10);
+	out[9] = static_cast<char>('0' + day % 10);
+}
+
+
+
+
+
+// --- helper functions definition ---
+static inline bool	isDigitChar(char c)
+{
+	return (c >= '0' && c <= '9');
+}
+
+static bool	parseDateScalar(const char* str, int& year, int& month, int& day)
+{
+	static const int	digit_pos[8] = {0, 1, 2, 3, 5, 6, 8, 9};
+
+	if (str[4] != '-' || str[7] != '-')
+		return (false);
+	for (int i = 0; i < 8; i++)
+	{
+		if (!isDigitChar(str[digit_pos[i]]))
+			return (false);
+	}
+
+	year = (str[0] - '0') * 1000 + (str[1] - '0') * 100
+		+ (str[2] - '0') * 10 + (str[3] - '0');
+	month = (str[5] - '0') * 10 + (str[6] - '0');
+	day = (str[8] - '0') * 10 + (str[9] - '0');
+
+	if (month < 1 || month > 12)
+		return (false);
+	if (dayIsInvalid(day, month, year))
+		return (false);
+
+	return (true);
+}
+
+static bool	parseDatePrefixScalar(const char* str, int& year, int& month,
+				int& day)
+{
+	if (str[DATE_LEN] != ' ' || str[DATE_LEN + 1] != '|'
+		|| str[DATE_LEN + 2] != ' ' || !isDigitChar(str[DATE_LEN + 3]))
+		return (false);
+	return (parseDateScalar(str, year, month, day));
+}
+
+static DateParser	selectDateParser(bool prefix)
+{
+#ifdef DATES_SSSE3
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("ssse3"))
+		return (prefix ? parseDatePrefixSsse3 : parseDateSsse3);
+#endif
+	return (prefix ? parseDatePrefixScalar : parseDateScalar);
+}
+
+#ifdef DATES_SSSE3
+// The ten date bytes go into one register (two loads, never past
+// str + DATE_LEN) and are checked and folded by the helpers below.
+__attribute__((target("ssse3")))
+static bool	parseDateSsse3(const char* str, int& year, int& month, int& day)
+{
+	uint16_t	tail;
+
+	std::memcpy(&tail, str + 8, sizeof(tail));
+	__m128i	text = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(str));
+	text = _mm_insert_epi16(text, tail, 4);
+
+	// lanes 0-9: digit where "YYYY-MM-DD" has one, '-' at 4 and 7
+	const __m128i	digit_lanes = _mm_setr_epi8(-1, -1, -1, -1, 0, -1, -1, 0,
+		-1, -1, 0, 0, 0, 0, 0, 0);
+	const __m128i	literals = _mm_setr_epi8(0, 0, 0, 0, '-', 0, 0, '-',
+		0, 0, 0, 0, 0, 0, 0, 0);
+	if (!matchShapeSsse3(text, digit_lanes, literals, 0x3ff))
+		return (false);
+	return (foldDateSsse3(text, year, month, day));
+}
+
+// Same for the fourteen bytes "YYYY-MM-DD | d": two overlapping 8-byte
+// loads (never past str + DATE_PREFIX_LEN) fill lanes 0-13, so the date,
+// the separator and the first value digit pass one shape check.
+__attribute__((target("ssse3")))
+static bool	parseDatePrefixSsse3(const char* str, int& year, int& month,
+				int& day)
+{
+	__m128i	head = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(str));
+	__m128i	tail = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(str
+		+ DATE_PREFIX_LEN - 8));
+	__m128i	text = _mm_unpacklo_epi64(head, _mm_srli_si128(tail, 2));
+
+	// lanes 0-13: the date as above, then ' ', '|', ' ' and a digit
+	const __m128i	digit_lanes = _mm_setr_epi8(-1, -1, -1, -1, 0, -1, -1, 0,
+		-1, -1, 0, 0, 0, -1, 0, 0);
+	const __m128i	literals = _mm_setr_epi8(0, 0, 0, 0, '-', 0, 0, '-',
+		0, 0, ' ', '|', ' ', 0, 0, 0);
+	if (!matchShapeSsse3(text, digit_lanes, literals, 0x3fff))
+		return (false);
+	return (foldDateSsse3(text, year, month, day));
+}
+
+// One compare pair and a movemask: each of the low lanes (the bits of
+// lanes) holds a digit where digit_lanes is set, its literal elsewhere.
+__attribute__((target("ssse3")))
+static bool	matchShapeSsse3(__m128i text, __m128i digit_lanes, __m128i literals,
+				int lanes)
+{
+	__m128i	values = _mm_sub_epi8(text, _mm_set1_epi8('0'));
+	__m128i	digits = _mm_cmpeq_epi8(_mm_min_epu8(values, _mm_set1_epi8(9)),
+		values);
+	__m128i	matches = _mm_cmpeq_epi8(text, literals);
+	__m128i	shape = _mm_or_si128(_mm_and_si128(digits, digit_lanes),
+		_mm_andnot_si128(digit_lanes, matches));
+
+	return ((_mm_movemask_epi8(shape) & lanes) == lanes);
+}
+
+// A shuffle packs the eight date digits, pmaddubsw folds them into the
+// pairs YY YY MM DD and pmaddwd the year pairs into the year.
+__attribute__((target("ssse3")))
+static bool	foldDateSsse3(__m128i text, int& year, int& month, int& day)
+{
+	const __m128i	pack = _mm_setr_epi8(0, 1, 2, 3, 5, 6, 8, 9,
+		-1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i	tens = _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1,
+		0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i	hundreds = _mm_setr_epi16(100, 1, 1, 0, 0, 0, 0, 0);
+	__m128i	values = _mm_sub_epi8(text, _mm_set1_epi8('0'));
+	__m128i	pairs = _mm_maddubs_epi16(_mm_shuffle_epi8(values, pack), tens);
+	__m128i	fields = _mm_madd_epi16(pairs, hundreds);
+
+	year = _mm_cvtsi128_si32(fields);
+	month = _mm_cvtsi128_si32(_mm_srli_si128(fields, 4));
+	day = _mm_extract_epi16(pairs, 3);
+
+	if (month < 1 || month > 12)
+		return (false);
+	if (dayIsInvalid(day, month, year))
+		return (false);
+
+	return (true);
+}
+#endif
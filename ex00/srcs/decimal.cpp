@@ -0,0 +1,216 @@
+#include "decimal.hpp"
+
+#define MANTISSA_DIGITS_MAX 19
+#define EXPONENT_CLAMP 10000
+
+// --- helper functions declaration ---
+static inline bool	isDigitChar(char c);
+static bool			scaleMantissa(uint64_t mantissa, int exponent, int dropped,
+						uint64_t& scaled);
+
+// --- decimal ---
+// Reads the longest "[+-]digits[.digits][(e|E)[+-]digits]" prefix at cur,
+// the same characters operator>>(float&) accepts, into a Decimal. Digits
+// past DECIMAL_DIGITS decimals are rounded half away from zero; values
+// that do not fit fail. On success cur is left just past the number.
+bool	scanDecimal(const char*& cur, const char* end, Decimal& value)
+{
+	const char*	p = cur;
+	bool		negative = false;
+	uint64_t	mantissa = 0;
+	int			kept = 0;
+	int			digits = 0;
+	int			exponent = 0;
+	int			dropped = -1;
+
+	if (p < end && (*p == '+' || *p == '-'))
+		negative = (*p++ == '-');
+
+	for (; p < end && isDigitChar(*p); p++, digits++)
+	{
+		if (kept < MANTISSA_DIGITS_MAX)
+		{
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+			kept += (mantissa != 0);
+		}
+		else
+		{
+			if (dropped < 0)
+				dropped = *p - '0';
+			exponent++;
+		}
+	}
+	if (p < end && *p == '.')
+	{
+		for (p++; p < end && isDigitChar(*p); p++, digits++)
+		{
+			if (kept < MANTISSA_DIGITS_MAX)
+			{
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+				kept += (mantissa != 0);
+				exponent--;
+			}
+			else if (dropped < 0)
+				dropped = *p - '0';
+		}
+	}
+	if (digits == 0)
+		return (false);
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		bool	exp_negative = false;
+		int		exp_value = 0;
+
+		p++;
+		if (p < end && (*p == '+' || *p == '-'))
+			exp_negative = (*p++ == '-');
+		if (p == end || !isDigitChar(*p))
+			return (false);
+		for (; p < end && isDigitChar(*p); p++)
+		{
+			if (exp_value < EXPONENT_CLAMP)
+				exp_value = exp_value * 10 + (*p - '0');
+		}
+		exponent += exp_negative ? -exp_value : exp_value;
+	}
+
+	uint64_t	scaled;
+	if (!scaleMantissa(mantissa, exponent + DECIMAL_DIGITS, dropped, scaled))
+		return (false);
+
+	value = negative ? -static_cast<Decimal>(scaled) : static_cast<Decimal>(scaled);
+	cur = p;
+	return (true);
+}
+
+// a * b rounded half away from zero; false when it does not fit
+bool	mulDecimal(Decimal a, Decimal b, Decimal& product)
+{
+	bool	negative = (a < 0) != (b < 0);
+	uint64_t	ua = a < 0 ? 0 - static_cast<uint64_t>(a) : static_cast<uint64_t>(a);
+	uint64_t	ub = b < 0 ? 0 - static_cast<uint64_t>(b) : static_cast<uint64_t>(b);
+
+	__extension__ typedef unsigned __int128	uint128;
+
+	uint128	wide = static_cast<uint128>(ua) * ub + DECIMAL_SCALE / 2;
+	wide /= DECIMAL_SCALE;
+	if (wide > static_cast<uint128>(INT64_MAX))
+		return (false);
+
+	product = negative ? -static_cast<Decimal>(wide) : static_cast<Decimal>(wide);
+	return (true);
+}
+
+// shortest exact text: no exponent, no trailing zeros; returns the length
+size_t	formatDecimal(Decimal value, char* out)
+{
+	uint64_t	magnitude = value < 0 ? 0 - static_cast<uint64_t>(value)
+		: static_cast<uint64_t>(value);
+	uint64_t	whole = magnitude / DECIMAL_SCALE;
+	uint64_t	frac = magnitude % DECIMAL_SCALE;
+	char		digits[24];
+	size_t		len = 0;
+	size_t		n = 0;
+
+	if (value < 0)
+		out[len++] = '-';
+	do
+	{
+		digits[n++] = static_cast<char>('0' + whole % 10);
+		whole /= 10;
+	} while (whole);
+	while (n > 0)
+		out[len++] = digits[--n];
+
+	if (frac)
+	{
+		int	width = DECIMAL_DIGITS;
+
+		while (frac % 10 == 0)
+		{
+			frac /= 10;
+			width--;
+		}
+		out[len++] = '.';
+		for (int i = width - 1; i >= 0; i--)
+		{
+			out[len + static_cast<size_t>(i)] = static_cast<char>('0' + frac % 10);
+			frac /= 10;
+		}
+		len += static_cast<size_t>(width);
+	}
+	return (len);
+}
+
+double	decimalToDouble(Decimal value)
+{
+	return (static_cast<double>(value) / static_cast<double>(DECIMAL_SCALE));
+}
+
+// sum / count rounded half away from zero; the caller knows it fits, as
+// for the mean of count Decimals
+Decimal	divideSum(DecimalSum sum, uint64_t count)
+{
+	bool		negative = sum < 0;
+	DecimalSum	magnitude = negative ? -sum : sum;
+	DecimalSum	quotient = (magnitude + count / 2) / count;
+
+	return (static_cast<Decimal>(negative ? -quotient : quotient));
+}
+
+
+
+
+
+// --- helper functions definition ---
+static inline bool	isDigitChar(char c)
+{
+	return (c >= '0' && c <= '9');
+}
+
+// Mantissa * 10^exponent, rounded half up to an integer that fits a
+// Decimal. dropped is the first digit that did not fit in mantissa (-1 if
+// none); it only decides the rounding when nothing else is cut off.
+static bool	scaleMantissa(uint64_t mantissa, int exponent, int dropped,
+				uint64_t& scaled)
+{
+	if (mantissa == 0)
+	{
+		scaled = 0;
+		return (true);
+	}
+	if (exponent == 0 && dropped >= 5)
+	{
+		if (mantissa == UINT64_MAX)
+			return (false);
+		mantissa++;
+	}
+
+	for (; exponent > 0; exponent--)
+	{
+		if (mantissa > static_cast<uint64_t>(INT64_MAX) / 10)
+			return (false);
+		mantissa *= 10;
+	}
+	if (exponent < 0)
+	{
+		// mantissa has at most MANTISSA_DIGITS_MAX digits, so past 10^19,
+		// the largest divisor a uint64_t holds, it always rounds to 0
+		if (exponent <= -MANTISSA_DIGITS_MAX - 1)
+		{
+			scaled = 0;
+			return (true);
+		}
+
+		uint64_t	divisor = 1;
+		for (; exponent < 0; exponent++)
+			divisor *= 10;
+		mantissa = mantissa / divisor + (mantissa % divisor >= (divisor + 1) / 2);
+	}
+	if (mantissa > static_cast<uint64_t>(INT64_MAX))
+		return (false);
+
+	scaled = mantissa;
+	return (true);
+}
@@ -1,33 +1,94 @@
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <unistd.h>
+#include <vector>
 
 #include "colors.hpp"
 #include "dictionary.hpp"
 #include "BitcoinExchange.class.hpp"
+#include "profile.hpp"
+#include "QueryServer.class.hpp"
+
+// --- command line options ---
+struct Options
+{
+	const char*	infile;
+	bool		dense;
+	bool		verbose;
+	bool		snapshot;
+	bool		legacy_reader;
+	size_t		threads;
+	bool		plain;
+	OutputFormat	format;
+	const char*	errors;
+	const char*	serve;
+	size_t		dense_budget;
+	std::vector<const char*>	series;
+	const char*	series_table;
+};
 
 // --- helper functions declaration ---
+static int	parseArgs(int ac, char** av, Options& opts);
+static bool	parseSize(const char* str, size_t& size);
+static void	printLoadReport(const char* label, const LoadReport& report);
+static void	printLookupStats(const LookupStats& stats);
+static int	loadSeries(BitcoinExchange& btc_obj, const Options& opts);
+static void	printSeries(const RateStore& store);
+static int	runServer(const Options& opts);
 static int	badInput();
 static int	badInfile();
 static int	badDatabase();
+static int	badSeries(const char* spec);
+static int	badErrorFile(const char* path);
+static int	badSocket(const char* path);
 
 // --- main function ---
 int main(int ac, char** av)
 {
-	if (ac != 2)
+	Options	opts;
+
+	if (parseArgs(ac, av, opts) == ERROR)
 		return (badInput());
+	if (opts.serve)
+		return (runServer(opts));
+	PROFILE_INSTALL();
 
-	std::ifstream infile(av[1]);
+	std::ifstream infile(opts.infile);
 	if (!infile)
 		return (badInfile());
 
-	std::ifstream dbfile("data.csv");
-	if (!dbfile)
+	BitcoinExchange	btc_obj(infile);
+
+	if (btc_obj.loadDatabase("data.csv", opts.snapshot) == ERROR)
 		return (badDatabase());
+	if (opts.verbose)
+		printLoadReport("Database:", btc_obj.loadReport());
+	if (loadSeries(btc_obj, opts) != OK)
+		return (NOK);
+	if (opts.verbose && opts.series_table)
+		printLoadReport("Table:", btc_obj.tableReport());
+	if (opts.verbose)
+		printSeries(btc_obj.store());
 
-	BitcoinExchange	btc_obj(infile, dbfile);
+	if (opts.dense)
+		btc_obj.enableDenseLookup(opts.dense_budget);
+	btc_obj.setPlainOutput(opts.plain);
+	btc_obj.setOutputFormat(opts.format);
+	if (opts.errors && btc_obj.redirectErrors(opts.errors) == ERROR)
+		return (badErrorFile(opts.errors));
 
-	btc_obj.readInfile();
+	if (opts.legacy_reader)
+		btc_obj.readInfileLegacy();
+	else if (opts.threads > 1)
+		btc_obj.readInfileParallel(opts.threads);
+	else
+		btc_obj.readInfile();
+	if (opts.verbose)
+		printLookupStats(btc_obj.lookupStats());
 
 	return (OK);
 }
@@ -37,10 +98,177 @@ int main(int ac, char** av)
 
 
 // --- helper functions definition ---
+static int	parseArgs(int ac, char** av, Options& opts)
+{
+	opts.infile = NULL;
+	opts.dense = false;
+	opts.verbose = false;
+	opts.snapshot = true;
+	opts.legacy_reader = false;
+	opts.threads = 1;
+	opts.plain = false;
+	opts.format = FORMAT_TEXT;
+	opts.errors = NULL;
+	opts.serve = NULL;
+	opts.dense_budget = DENSE_BUDGET_DEFAULT;
+	opts.series_table = NULL;
+
+	for (int i = 1; i < ac; i++)
+	{
+		std::string	arg = av[i];
+
+		if (arg == "--verbose")
+			opts.verbose = true;
+		else if (arg == "--no-snapshot")
+			opts.snapshot = false;
+		else if (arg == "--plain")
+			opts.plain = true;
+		else if (arg == "--format" && i + 1 < ac)
+		{
+			if (!parseOutputFormat(av[++i], opts.format))
+				return (ERROR);
+		}
+		else if (arg == "--errors" && i + 1 < ac)
+			opts.errors = av[++i];
+		else if (arg == "--serve" && i + 1 < ac)
+			opts.serve = av[++i];
+		else if (arg == "--db" && i + 1 < ac)
+			opts.series.push_back(av[++i]);
+		else if (arg == "--db-table" && i + 1 < ac)
+			opts.series_table = av[++i];
+		else if (arg == "--legacy-reader")
+			opts.legacy_reader = true;
+		else if (arg == "--threads" && i + 1 < ac)
+		{
+			if (!parseSize(av[++i], opts.threads)
+				|| opts.threads < 1 || opts.threads > THREADS_MAX)
+				return (ERROR);
+		}
+		else if (arg == "--dense")
+			opts.dense = true;
+		else if (arg.compare(0, 8, "--dense=") == OK)
+		{
+			opts.dense = true;
+			if (!parseSize(av[i] + 8, opts.dense_budget))
+				return (ERROR);
+		}
+		else if (arg.compare(0, 2, "--") == OK || opts.infile)
+			return (ERROR);
+		else
+			opts.infile = av[i];
+	}
+
+	// the server answers one line per request and only knows data.csv
+	if (opts.serve)
+		return ((opts.infile || opts.format == FORMAT_BINARY
+			|| !opts.series.empty() || opts.series_table) ? ERROR : OK);
+	// the legacy reader only speaks the original text output
+	if (!opts.infile || (opts.legacy_reader && opts.format != FORMAT_TEXT))
+		return (ERROR);
+	return (OK);
+}
+
+// accepts a byte count with an optional K, M or G suffix
+static bool	parseSize(const char* str, size_t& size)
+{
+	char*			end;
+	unsigned long	value = std::strtoul(str, &end, 10);
+
+	if (end == str || *str == '-')
+		return (false);
+	int	shift = 0;
+	if (*end == 'K' || *end == 'k')
+		shift = 10;
+	else if (*end == 'M' || *end == 'm')
+		shift = 20;
+	else if (*end == 'G' || *end == 'g')
+		shift = 30;
+	if (shift)
+	{
+		value <<= shift;
+		end++;
+	}
+	if (*end != '\0')
+		return (false);
+
+	size = value;
+	return (true);
+}
+
+static void	printLoadReport(const char* label, const LoadReport& report)
+{
+	std::cerr << BLUE << label << RESET " " << report.rows << " rows loaded, "
+		<< report.skipped << " skipped, " << report.bytes << " bytes in "
+		<< report.seconds * 1000.0 << " ms (" << rowsPerSecond(report)
+		<< " rows/s)" << (report.from_snapshot ? " from snapshot" : "")
+		<< std::endl;
+}
+
+// every --db SYMBOL=PATH, then the --db-table, then the symbol table
+static int	loadSeries(BitcoinExchange& btc_obj, const Options& opts)
+{
+	for (size_t i = 0; i < opts.series.size(); i++)
+	{
+		const char*	spec = opts.series[i];
+		const char*	eq = std::strchr(spec, '=');
+
+		if (!eq || !isSymbolName(spec, eq - spec) || eq[1] == '\0'
+			|| btc_obj.loadSeries(std::string(spec, eq - spec), eq + 1,
+				opts.snapshot) == ERROR)
+			return (badSeries(spec));
+	}
+	if (opts.series_table && btc_obj.loadSeriesTable(opts.series_table) == ERROR)
+		return (badSeries(opts.series_table));
+	btc_obj.buildSymbolTable();
+	return (OK);
+}
+
+static void	printSeries(const RateStore& store)
+{
+	for (size_t i = 0; i < store.size(); i++)
+	{
+		const RateStore::Series&	series = store.at(i);
+
+		std::cerr << BLUE "Symbol " << series.name << ":" RESET << " "
+			<< series.index->size() << " rows, " << store.memoryUsage(i)
+			<< " bytes" << std::endl;
+	}
+}
+
+static void	printLookupStats(const LookupStats& stats)
+{
+	std::cerr << BLUE "Lookups:" RESET << " " << stats.merged << " merged, "
+		<< stats.searched << " searched, " << stats.direct << " direct"
+		<< std::endl;
+}
+
+// "-" serves a single session on stdin/stdout, anything else is a socket path
+static int	runServer(const Options& opts)
+{
+	QueryServer	server("data.csv", opts.snapshot, opts.dense, opts.dense_budget);
+
+	if (server.load() == ERROR)
+		return (badDatabase());
+	server.setFormat(opts.format);
+
+	if (!std::strcmp(opts.serve, "-"))
+		return (server.serveStream(STDIN_FILENO, STDOUT_FILENO));
+
+	signal(SIGPIPE, SIG_IGN);
+	if (server.serveSocket(opts.serve) == ERROR)
+		return (badSocket(opts.serve));
+	return (OK);
+}
+
 static int	badInput()
 {
 	std::cerr << RED "Error:" RESET << " bad usage => ";
-	std::cerr << "./btc <infile>" << std::endl;
+	std::cerr << "./btc [--verbose] [--plain] [--no-snapshot] [--dense[=BYTES]]"
+		" [--legacy-reader | --threads N]"
+		" [--format text|csv|ndjson|binary] [--errors FILE]"
+		" [--db SYMBOL=PATH]... [--db-table PATH] <infile>" << std::endl;
+	std::cerr << "       ./btc [--no-snapshot] [--dense[=BYTES]]"
+		" [--format text|csv|ndjson] --serve SOCKET|-" << std::endl;
 
 	return (NOK);
 }
@@ -58,3 +286,24 @@ static int	badDatabase()
 
 	return (NOK);
 }
+
+static int	badSeries(const char* spec)
+{
+	std::cerr << RED "Error:" RESET << " could not load \"" << spec << "\"." << std::endl;
+
+	return (NOK);
+}
+
+static int	badErrorFile(const char* path)
+{
+	std::cerr << RED "Error:" RESET << " could not open \"" << path << "\"." << std::endl;
+
+	return (NOK);
+}
+
+static int	badSocket(const char* path)
+{
+	std::cerr << RED "Error:" RESET << " could not listen on \"" << path << "\"." << std::endl;
+
+	return (NOK);
+}
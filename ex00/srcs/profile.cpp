@@ -0,0 +1,206 @@
+#ifdef BTC_PROFILE
+
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+
+#include "profile.hpp"
+
+// one counter per LineStatus
+#define LINE_KINDS (LINE_BAD_SYMBOL + 1)
+#define REPORT_SIZE 4096
+
+// Shared by every reader thread: updated with atomic adds, read without
+// locking by the report (a signal may catch them mid-run, which is fine
+// for a progress report).
+struct ProfileCounters
+{
+	uint64_t	phase_ns[PHASE_COUNT];
+	uint64_t	phase_calls[PHASE_COUNT];
+	uint64_t	lines[LINE_KINDS];
+	uint64_t	latency[PROFILE_BUCKETS];
+};
+
+// the report is built with these instead of stdio so that the SIGUSR1
+// handler only calls async-signal-safe functions
+struct ReportBuffer
+{
+	char	data[REPORT_SIZE];
+	size_t	len;
+};
+
+// --- helper functions declaration ---
+static void	onReportSignal(int sig);
+static void	onExit();
+static void	appendText(ReportBuffer& buf, const char* str);
+static void	appendNumber(ReportBuffer& buf, uint64_t value, size_t width);
+static void	appendMillis(ReportBuffer& buf, uint64_t ns);
+
+static ProfileCounters	g_profile;
+
+static const char*	g_phase_names[PHASE_COUNT] = {
+	"load    ", "parse   ", "lookup  ", "format  "
+};
+
+static const char*	g_line_names[LINE_KINDS] = {
+	"valid     ", "range     ", "bad line  ", "bad date  ", "bad value ",
+	"too large ", "bad symbol"
+};
+
+// --- profiling ---
+uint64_t	profileNow()
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL
+		+ static_cast<uint64_t>(ts.tv_nsec));
+}
+
+void	profileAdd(ProfilePhase phase, uint64_t start)
+{
+	__sync_fetch_and_add(&g_profile.phase_ns[phase], profileNow() - start);
+	__sync_fetch_and_add(&g_profile.phase_calls[phase], 1);
+}
+
+// a lookup phase sample that also goes into the latency histogram, in
+// buckets [2^(k-1), 2^k) ns
+void	profileLookup(uint64_t start)
+{
+	uint64_t	ns = profileNow() - start;
+	size_t		bucket = 0;
+
+	while (bucket + 1 < PROFILE_BUCKETS && (ns >> bucket) != 0)
+		bucket++;
+	__sync_fetch_and_add(&g_profile.phase_ns[PHASE_LOOKUP], ns);
+	__sync_fetch_and_add(&g_profile.phase_calls[PHASE_LOOKUP], 1);
+	__sync_fetch_and_add(&g_profile.latency[bucket], 1);
+}
+
+void	profileLine(LineStatus status)
+{
+	__sync_fetch_and_add(&g_profile.lines[status], 1);
+}
+
+void	profileInstall()
+{
+	signal(SIGUSR1, onReportSignal);
+	std::atexit(onExit);
+}
+
+void	profileReport()
+{
+	ReportBuffer	buf;
+	uint64_t		accepted = g_profile.lines[LINE_VALID]
+		+ g_profile.lines[LINE_RANGE];
+	uint64_t		rejected = 0;
+
+	buf.len = 0;
+	for (int i = LINE_RANGE + 1; i < LINE_KINDS; i++)
+		rejected += g_profile.lines[i];
+
+	appendText(buf, "Profile:\n");
+	for (int i = 0; i < PHASE_COUNT; i++)
+	{
+		appendText(buf, "  ");
+		appendText(buf, g_phase_names[i]);
+		appendMillis(buf, g_profile.phase_ns[i]);
+		appendText(buf, " ms in ");
+		appendNumber(buf, g_profile.phase_calls[i], 0);
+		appendText(buf, " calls\n");
+	}
+
+	appendText(buf, "  lines    ");
+	appendNumber(buf, accepted, 0);
+	appendText(buf, " accepted, ");
+	appendNumber(buf, rejected, 0);
+	appendText(buf, " rejected\n");
+	for (int i = 0; i < LINE_KINDS; i++)
+	{
+		if (!g_profile.lines[i])
+			continue;
+		appendText(buf, "    ");
+		appendText(buf, g_line_names[i]);
+		appendNumber(buf, g_profile.lines[i], 12);
+		appendText(buf, "\n");
+	}
+
+	appendText(buf, "  lookup latency:\n");
+	for (int i = 0; i < PROFILE_BUCKETS; i++)
+	{
+		if (!g_profile.latency[i])
+			continue;
+		appendText(buf, "    < ");
+		appendNumber(buf, static_cast<uint64_t>(1) << i, 10);
+		appendText(buf, " ns ");
+		appendNumber(buf, g_profile.latency[i], 12);
+		appendText(buf, "\n");
+	}
+
+	const char*	cur = buf.data;
+	while (buf.len > 0)
+	{
+		ssize_t	written = write(STDERR_FILENO, cur, buf.len);
+
+		if (written <= 0)
+			break;
+		cur += written;
+		buf.len -= static_cast<size_t>(written);
+	}
+}
+
+
+
+
+
+// --- helper functions definition ---
+static void	onReportSignal(int sig)
+{
+	(void)sig;
+	profileReport();
+}
+
+static void	onExit()
+{
+	profileReport();
+}
+
+static void	appendText(ReportBuffer& buf, const char* str)
+{
+	while (*str && buf.len < REPORT_SIZE)
+		buf.data[buf.len++] = *str++;
+}
+
+// right-aligned in width columns (0: no padding)
+static void	appendNumber(ReportBuffer& buf, uint64_t value, size_t width)
+{
+	char	digits[24];
+	size_t	len = 0;
+
+	do
+	{
+		digits[sizeof(digits) - ++len] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value > 0);
+	while (width > len && buf.len < REPORT_SIZE)
+	{
+		buf.data[buf.len++] = ' ';
+		width--;
+	}
+	for (size_t i = sizeof(digits) - len; i < sizeof(digits)
+		&& buf.len < REPORT_SIZE; i++)
+		buf.data[buf.len++] = digits[i];
+}
+
+static void	appendMillis(ReportBuffer& buf, uint64_t ns)
+{
+	uint64_t	micros = ns / 1000 % 1000;
+
+	appendNumber(buf, ns / 1000000, 8);
+	appendText(buf, ".");
+	appendText(buf, micros < 100 ? (micros < 10 ? "00" : "0") : "");
+	appendNumber(buf, micros, 0);
+}
+
+#endif // #ifdef BTC_PROFILE
@@ -0,0 +1,193 @@
+#include <cstring>
+
+#include "dates.hpp"
+#include "dictionary.hpp"
+#include "scanners.hpp"
+
+// --- helper functions declaration ---
+static const char*	skipBlanks(const char* cur, const char* end);
+static const char*	tokenEnd(const char* cur, const char* end);
+static bool			validInfileDate(const char* token, size_t len, int& day);
+static const char*	scanSymbol(const char* begin, const char* end,
+						InputLine& line);
+static LineStatus	scanRangeEnd(const char* from, const char* to,
+						const char* to_end, const char* end, InputLine& line);
+static LineStatus	scanValue(const char* date, const char* value,
+						const char* value_end, const char* end, InputLine& line);
+
+// --- scanners ---
+// same set as std::isspace in the "C" locale
+bool	isBlank(char c)
+{
+	return (c == ' ' || (c >= '\t' && c <= '\r'));
+}
+
+// symbols are a letter then letters, digits, '.', '_' or '-'
+bool	isSymbolName(const char* name, size_t len)
+{
+	if (len == 0 || len > SYMBOL_MAX)
+		return (false);
+	if (!((name[0] >= 'A' && name[0] <= 'Z') || (name[0] >= 'a' && name[0] <= 'z')))
+		return (false);
+	for (size_t i = 1; i < len; i++)
+	{
+		char	c = name[i];
+
+		if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')
+			|| (c >= '0' && c <= '9') || c == '.' || c == '_' || c == '-'))
+			return (false);
+	}
+	return (true);
+}
+
+// Allocation-free equivalent of reading "date sep value" with operator>>:
+// same tokenisation on blanks and the same checks, in the same order, as
+// the istringstream based isValidLine. A ".." separator makes the line a
+// range query whose end date gets the same checks as the first one. A
+// symbol name followed by three or more tokens is taken as a prefix.
+// A line starting with the canonical "YYYY-MM-DD | d" skips the
+// tokenising up to the value: parseDatePrefix checks it in one go.
+LineStatus	scanInputLine(const char* begin, const char* end, InputLine& line)
+{
+	int	year, month, mday;
+
+	if (end - begin >= DATE_PREFIX_LEN
+		&& parseDatePrefix(begin, year, month, mday)
+		&& year >= INFILE_YEAR_MIN && year <= INFILE_YEAR_MAX)
+	{
+		const char*	value = begin + DATE_PREFIX_LEN - 1;
+
+		line.symbol = NULL;
+		line.symbol_len = 0;
+		line.token = begin;
+		line.token_len = static_cast<size_t>(end - begin);
+		line.day = daysFromCivil(year, month, mday);
+		return (scanValue(begin, value, tokenEnd(value, end), end, line));
+	}
+
+	const char*	start = scanSymbol(begin, end, line);
+	const char*	date = skipBlanks(start, end);
+	const char*	date_end = tokenEnd(date, end);
+	const char*	sep = skipBlanks(date_end, end);
+	const char*	sep_end = tokenEnd(sep, end);
+	const char*	value = skipBlanks(sep_end, end);
+	const char*	value_end = tokenEnd(value, end);
+
+	line.token = begin;
+	line.token_len = static_cast<size_t>(end - begin);
+	if (value == value_end)
+		return (LINE_BAD_LINE);
+
+	if (!validInfileDate(date, static_cast<size_t>(date_end - date), line.day))
+	{
+		line.token = date;
+		line.token_len = static_cast<size_t>(date_end - date);
+		return (LINE_BAD_DATE);
+	}
+
+	if (static_cast<size_t>(sep_end - sep) == std::strlen(INFILE_RANGE_SEP)
+		&& !std::memcmp(sep, INFILE_RANGE_SEP, std::strlen(INFILE_RANGE_SEP)))
+		return (scanRangeEnd(date, value, value_end, end, line));
+	if (sep_end - sep != 1 || *sep != '|')
+		return (LINE_BAD_LINE);
+	return (scanValue(date, value, value_end, end, line));
+}
+
+
+
+
+
+// --- helper functions definition ---
+static const char*	skipBlanks(const char* cur, const char* end)
+{
+	while (cur < end && isBlank(*cur))
+		cur++;
+	return (cur);
+}
+
+static const char*	tokenEnd(const char* cur, const char* end)
+{
+	while (cur < end && !isBlank(*cur))
+		cur++;
+	return (cur);
+}
+
+// where the date | value part starts, past the symbol if there is one
+static const char*	scanSymbol(const char* begin, const char* end,
+						InputLine& line)
+{
+	const char*	symbol = skipBlanks(begin, end);
+	const char*	symbol_end = tokenEnd(symbol, end);
+	const char*	cur = symbol_end;
+
+	line.symbol = NULL;
+	line.symbol_len = 0;
+	if (!isSymbolName(symbol, static_cast<size_t>(symbol_end - symbol)))
+		return (begin);
+	for (int tokens = 0; tokens < 3; tokens++)
+	{
+		cur = skipBlanks(cur, end);
+		if (cur == end)
+			return (begin);
+		cur = tokenEnd(cur, end);
+	}
+
+	line.symbol = symbol;
+	line.symbol_len = static_cast<size_t>(symbol_end - symbol);
+	return (symbol_end);
+}
+
+// the "to" date of "from .. to"; a range running backwards is a bad line
+static LineStatus	scanRangeEnd(const char* from, const char* to,
+						const char* to_end, const char* end, InputLine& line)
+{
+	if (!validInfileDate(to, static_cast<size_t>(to_end - to), line.to_day))
+	{
+		line.token = to;
+		line.token_len = static_cast<size_t>(to_end - to);
+		return (LINE_BAD_DATE);
+	}
+	if (skipBlanks(to_end, end) != end || line.to_day < line.day)
+		return (LINE_BAD_LINE);
+
+	line.token = from;
+	line.token_len = DATE_LEN;
+	return (LINE_RANGE);
+}
+
+static bool	validInfileDate(const char* token, size_t len, int& day)
+{
+	int	year, month, mday;
+
+	if (len != DATE_LEN || !parseDate(token, year, month, mday))
+		return (false);
+	if (year < INFILE_YEAR_MIN || year > INFILE_YEAR_MAX)
+		return (false);
+
+	day = daysFromCivil(year, month, mday);
+	return (true);
+}
+
+// the value of "date | value" and the end of the line
+static LineStatus	scanValue(const char* date, const char* value,
+						const char* value_end, const char* end, InputLine& line)
+{
+	const char*	cur = value;
+
+	if (!scanDecimal(cur, value_end, line.value) || cur != value_end
+		|| line.value < 0 || line.value > INFILE_VALUE_MAX * DECIMAL_SCALE)
+	{
+		line.token = value;
+		line.token_len = static_cast<size_t>(value_end - value);
+		return (LINE_BAD_VALUE);
+	}
+
+	if (skipBlanks(value_end, end) != end)
+		return (LINE_BAD_LINE);
+
+	line.token = date;
+	line.token_len = DATE_LEN;
+	line.amount = value;
+	line.amount_len = static_cast<size_t>(value_end - value);
+	return (LINE_VALID);
+}
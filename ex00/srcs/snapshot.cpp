@@ -0,0 +1,183 @@
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "snapshot.hpp"
+
+// --- helper functions declaration ---
+static bool		csvStamp(const char* csv_path, SnapshotHeader& header);
+static uint64_t	checksum(const int* dates, const Decimal* rates, size_t count);
+static bool		writeAll(int fd, const void* buf, size_t len);
+
+// --- snapshot ---
+std::string	snapshotPath(const char* csv_path)
+{
+	return (std::string(csv_path) + SNAPSHOT_SUFFIX);
+}
+
+// Maps the snapshot next to csv_path and hands its arrays to index. Fails
+// (leaving index untouched) when the snapshot is missing, truncated, from
+// another version, corrupted, or older than the CSV's size and mtime.
+bool	loadSnapshot(const char* csv_path, RateIndex& index, size_t& csv_size)
+{
+	SnapshotHeader	expected;
+	if (!csvStamp(csv_path, expected))
+		return (false);
+
+	MappedFile*	file = new MappedFile();
+	if (!file->open(snapshotPath(csv_path).c_str())
+		|| file->size() < sizeof(SnapshotHeader))
+	{
+		delete file;
+		return (false);
+	}
+
+	const SnapshotHeader*	header
+		= reinterpret_cast<const SnapshotHeader*>(file->data());
+	uint64_t				count = header->count;
+	size_t					body = file->size() - sizeof(SnapshotHeader);
+
+	if (std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic))
+		|| header->version != SNAPSHOT_VERSION
+		|| header->header_size != sizeof(SnapshotHeader)
+		|| header->csv_size != expected.csv_size
+		|| header->csv_mtime_sec != expected.csv_mtime_sec
+		|| header->csv_mtime_nsec != expected.csv_mtime_nsec
+		|| count > body / (sizeof(int) + sizeof(Decimal))
+		|| body != count * (sizeof(int) + sizeof(Decimal)))
+	{
+		delete file;
+		return (false);
+	}
+
+	const Decimal*	rates = reinterpret_cast<const Decimal*>(header + 1);
+	const int*		dates = reinterpret_cast<const int*>(rates + count);
+
+	if (checksum(dates, rates, count) != header->checksum)
+	{
+		delete file;
+		return (false);
+	}
+
+	csv_size = static_cast<size_t>(header->csv_size);
+	index.attach(dates, rates, count, file);
+	return (true);
+}
+
+// Writes to a temporary file and renames it over the old snapshot, so a
+// concurrent reader never maps a half-written file. csv_size is how much
+// of the CSV index holds; if it has grown since, no snapshot is written.
+bool	writeSnapshot(const char* csv_path, const RateIndex& index,
+			size_t csv_size)
+{
+	SnapshotHeader	header;
+
+	std::memset(&header, 0, sizeof(header));
+	if (!csvStamp(csv_path, header) || header.csv_size != csv_size)
+		return (false);
+	std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	header.version = SNAPSHOT_VERSION;
+	header.header_size = sizeof(SnapshotHeader);
+	header.count = index.size();
+	header.checksum = checksum(index.dates(), index.rates(), index.size());
+
+	std::string			path = snapshotPath(csv_path);
+	std::ostringstream	tmp;
+	tmp << path << ".tmp." << getpid();
+
+	int	fd = open(tmp.str().c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return (false);
+
+	bool	ok = writeAll(fd, &header, sizeof(header))
+		&& writeAll(fd, index.rates(), index.size() * sizeof(Decimal))
+		&& writeAll(fd, index.dates(), index.size() * sizeof(int));
+
+	if (close(fd) < 0)
+		ok = false;
+	if (!ok || std::rename(tmp.str().c_str(), path.c_str()) < 0)
+	{
+		unlink(tmp.str().c_str());
+		return (false);
+	}
+	return (true);
+}
+
+
+// Prefers a valid snapshot of csv_path; otherwise parses the CSV and, when
+// snapshots are enabled, leaves a fresh one behind for the next run.
+bool	loadDatabaseFile(const char* csv_path, bool use_snapshot,
+			RateIndex& index, LoadReport& report)
+{
+	if (use_snapshot)
+	{
+		double	start = monotonicSeconds();
+
+		if (loadSnapshot(csv_path, index, report.source_size))
+		{
+			report.rows = index.size();
+			report.bytes = index.size() * (sizeof(int) + sizeof(Decimal));
+			report.seconds = monotonicSeconds() - start;
+			report.from_snapshot = true;
+			return (true);
+		}
+	}
+
+	if (!loadRateCsv(csv_path, index, report))
+		return (false);
+
+	if (use_snapshot)
+		writeSnapshot(csv_path, index, report.source_size);
+	return (true);
+}
+
+
+
+
+
+// --- helper functions definition ---
+static bool	csvStamp(const char* csv_path, SnapshotHeader& header)
+{
+	struct stat	st;
+
+	if (stat(csv_path, &st) < 0)
+		return (false);
+	header.csv_size = static_cast<uint64_t>(st.st_size);
+	header.csv_mtime_sec = static_cast<int64_t>(st.st_mtim.tv_sec);
+	header.csv_mtime_nsec = static_cast<int64_t>(st.st_mtim.tv_nsec);
+	return (true);
+}
+
+// 64-bit multiply-xorshift over the date and rate words
+static uint64_t	checksum(const int* dates, const Decimal* rates, size_t count)
+{
+	uint64_t	hash = 0x9e3779b97f4a7c15ULL ^ count;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		hash ^= static_cast<uint64_t>(rates[i])
+			+ (static_cast<uint64_t>(static_cast<uint32_t>(dates[i])) << 32);
+		hash *= 0xff51afd7ed558ccdULL;
+		hash ^= hash >> 33;
+	}
+	return (hash);
+}
+
+static bool	writeAll(int fd, const void* buf, size_t len)
+{
+	const char*	cur = static_cast<const char*>(buf);
+
+	while (len > 0)
+	{
+		ssize_t	written = write(fd, cur, len);
+
+		if (written <= 0)
+			return (false);
+		cur += written;
+		len -= static_cast<size_t>(written);
+	}
+	return (true);
+}
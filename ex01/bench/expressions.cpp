@@ -0,0 +1,62 @@
+#include "expressions.hpp"
+#include "RpnProgram.class.hpp"
+
+// --- functions ---
+// xorshift64*; state must not be 0
+uint64_t	nextRandom(uint64_t& state)
+{
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return (state * 2685821657736338717ULL);
+}
+
+size_t	randomBelow(uint64_t& state, size_t bound)
+{
+	return (static_cast<size_t>(nextRandom(state) % bound));
+}
+
+long long	randomBetween(uint64_t& state, long long low, long long high)
+{
+	uint64_t	span = static_cast<uint64_t>(high - low) + 1;
+
+	return (low + static_cast<long long>(nextRandom(state) % span));
+}
+
+// A well-formed expression of length tokens (one less when length is
+// even, at least one) whose stack never holds more than depth values:
+// literals in [-literals, literals] and binary operators from the
+// NULL-ended list, each operator placed as soon as the depth or the
+// literals left require it, else at random. Appends it with single spaces
+// and returns its token count.
+size_t	appendExpression(std::string& out, uint64_t& state, size_t length,
+			size_t depth, const char* const* operators, long long literals)
+{
+	size_t	count = 0;
+	size_t	pushes = (length > 1) ? (length + 1) / 2 : 1;
+	size_t	total = pushes * 2 - 1;
+	size_t	stack = 0;
+
+	while (operators[count])
+		count++;
+	if (depth < 2)
+		depth = 2;
+	for (size_t tokens = 0; pushes > 0 || stack > 1; tokens++)
+	{
+		if (tokens > 0)
+			out += ' ';
+		if (pushes > 0 && (stack < 2
+			|| (stack < depth && randomBelow(state, 2) == 0)))
+		{
+			appendRpnInteger(out, randomBetween(state, -literals, literals));
+			pushes--;
+			stack++;
+		}
+		else
+		{
+			out += operators[randomBelow(state, count)];
+			stack--;
+		}
+	}
+	return (total);
+}
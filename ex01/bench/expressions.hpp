@@ -0,0 +1,18 @@
+#ifndef EXPRESSIONS_HPP
+#define EXPRESSIONS_HPP
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+
+// Random RPN expressions for bench/rpn_bench and bench/rpn_fuzz. The
+// generator is xorshift64*, so a seed gives the same expressions on every
+// machine.
+
+uint64_t	nextRandom(uint64_t& state);
+size_t		randomBelow(uint64_t& state, size_t bound);
+long long	randomBetween(uint64_t& state, long long low, long long high);
+size_t		appendExpression(std::string& out, uint64_t& state, size_t length,
+				size_t depth, const char* const* operators, long long literals);
+
+#endif // #ifndef EXPRESSIONS_HPP
@@ -0,0 +1,195 @@
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "dictionary.hpp"
+#include "expressions.hpp"
+#include "RPN.hpp"
+#include "RpnBatch.class.hpp"
+#include "RpnProgram.class.hpp"
+
+// Generates random well-formed expressions and measures how fast each
+// evaluation path gets through them: RPN() one call per expression,
+// RpnProgram compile() and run() alone, and the batch mode on one thread
+// and on N. Reports expressions and tokens per second.
+// Usage: rpn_bench <expressions> <length> <depth> <threads> <seed>
+
+// --- helper functions declaration ---
+static void		benchRPN(const std::vector<std::string>& expressions,
+					size_t tokens);
+static void		benchProgram(const std::vector<std::string>& expressions,
+					size_t tokens);
+static void		benchBatch(const std::string& text, size_t expressions,
+					size_t tokens, size_t threads);
+static void		report(const char* label, double seconds, size_t expressions,
+					size_t tokens);
+static double	monotonicSeconds();
+
+// results land here so the timed loops are not optimised away
+static volatile long	g_sink;
+
+// swallows what RPN() prints
+class NullBuffer : public std::streambuf
+{
+	protected:
+		int	overflow(int c)
+		{
+			return (c);
+		}
+
+		std::streamsize	xsputn(const char*, std::streamsize count)
+		{
+			return (count);
+		}
+};
+
+// --- main function ---
+int	main(int ac, char** av)
+{
+	if (ac != 6)
+	{
+		std::cerr << "usage: rpn_bench <expressions> <length> <depth> <threads>"
+			" <seed>" << std::endl;
+		return (NOK);
+	}
+
+	static const char*	operators[] = {"+", "-", "*", "/", NULL};
+	size_t				count = std::strtoul(av[1], NULL, 10);
+	size_t				length = std::strtoul(av[2], NULL, 10);
+	size_t				depth = std::strtoul(av[3], NULL, 10);
+	size_t				threads = std::strtoul(av[4], NULL, 10);
+	uint64_t			state = std::strtoul(av[5], NULL, 10) | 1;
+	std::vector<std::string>	expressions(count);
+	std::string			text;
+	size_t				tokens = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		tokens += appendExpression(expressions[i], state, length, depth,
+			operators, 99);
+		text += expressions[i];
+		text += '\n';
+	}
+
+	std::cout << "expressions: " << count << ", tokens: " << tokens
+		<< " (length " << length << ", depth " << depth << ")" << std::endl;
+	benchRPN(expressions, tokens);
+	benchProgram(expressions, tokens);
+	benchBatch(text, count, tokens, 1);
+	if (threads > 1)
+		benchBatch(text, count, tokens, threads);
+	return (OK);
+}
+
+
+
+
+
+// --- helper functions definition ---
+// RPN() prints every result, so its output goes to a buffer that drops it
+static void	benchRPN(const std::vector<std::string>& expressions, size_t tokens)
+{
+	NullBuffer		null_buffer;
+	std::streambuf*	out = std::cout.rdbuf(&null_buffer);
+	std::streambuf*	err = std::cerr.rdbuf(&null_buffer);
+	long			errors = 0;
+	double			start = monotonicSeconds();
+
+	for (size_t i = 0; i < expressions.size(); i++)
+		errors += (RPN(expressions[i]) == ERROR);
+
+	double	seconds = monotonicSeconds() - start;
+	std::cout.rdbuf(out);
+	std::cerr.rdbuf(err);
+	report("RPN()", seconds, expressions.size(), tokens);
+	std::cout << "    errors: " << errors << std::endl;
+}
+
+static void	benchProgram(const std::vector<std::string>& expressions,
+				size_t tokens)
+{
+	RpnProgram			program;
+	std::vector<int>	stack;
+	long				sum = 0;
+	double				start = monotonicSeconds();
+
+	for (size_t i = 0; i < expressions.size(); i++)
+	{
+		int	result = 0;
+
+		program.compile(expressions[i]);
+		if (stack.size() <= program.maxDepth())
+			stack.resize(program.maxDepth() + 1);
+		if (program.run(&stack[0], result) == RPN_OK)
+			sum += result;
+	}
+
+	double	seconds = monotonicSeconds() - start;
+	g_sink = sum;
+	report("compile + run", seconds, expressions.size(), tokens);
+}
+
+// the batch reads the expressions back from a temporary file and writes
+// to /dev/null
+static void	benchBatch(const std::string& text, size_t expressions,
+				size_t tokens, size_t threads)
+{
+	char	path[] = "/tmp/rpn_bench.XXXXXX";
+	int		in_fd = mkstemp(path);
+	int		out_fd = open("/dev/null", O_WRONLY);
+
+	if (in_fd < 0 || out_fd < 0
+		|| write(in_fd, text.data(), text.size())
+			!= static_cast<ssize_t>(text.size())
+		|| lseek(in_fd, 0, SEEK_SET) != 0)
+	{
+		std::cerr << "could not write " << path << std::endl;
+		if (in_fd >= 0)
+		{
+			close(in_fd);
+			unlink(path);
+		}
+		if (out_fd >= 0)
+			close(out_fd);
+		return ;
+	}
+	unlink(path);
+
+	RpnBatch	batch(in_fd, out_fd, threads);
+	double		start = monotonicSeconds();
+	int			status = batch.run();
+	double		seconds = monotonicSeconds() - start;
+	char		label[32];
+
+	close(in_fd);
+	close(out_fd);
+	std::snprintf(label, sizeof(label), "batch, %lu thread%s",
+		static_cast<unsigned long>(threads), threads > 1 ? "s" : "");
+	report(label, seconds, expressions, tokens);
+	if (status == ERROR || batch.lines() != expressions)
+		std::cout << "    (FAILED)" << std::endl;
+}
+
+static void	report(const char* label, double seconds, size_t expressions,
+				size_t tokens)
+{
+	double	rate = seconds > 0.0 ? 1.0 / seconds : 0.0;
+
+	std::cout << "  " << label << ": " << seconds * 1000.0 << " ms, "
+		<< expressions * rate << " expressions/s, " << tokens * rate
+		<< " tokens/s" << std::endl;
+}
+
+static double	monotonicSeconds()
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (static_cast<double>(ts.tv_sec)
+		+ static_cast<double>(ts.tv_nsec) / 1e9);
+}
@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "dictionary.hpp"
+#include "expressions.hpp"
+#include "RpnProgram.class.hpp"
+
+// Differential fuzzing of the int evaluator: random expressions, from well
+// formed to token soup, are run through RpnProgram and through the plain
+// reference evaluator below, which reads tokens the way the original
+// istringstream parser did and applies each operator directly on a stack.
+// Their status, result and error offset must agree.
+// Usage: rpn_fuzz <cases> <seed>
+
+#define FUZZ_SHOWN 10
+
+// how one evaluation ended
+struct Outcome
+{
+	RpnStatus	status;
+	long long	value;
+	size_t		offset;
+};
+
+// --- helper functions declaration ---
+static void			generateCase(std::string& out, uint64_t& state);
+static Outcome		evaluateReference(const std::string& expression);
+static bool			referenceValue(const std::string& token, int& value);
+static int			referencePops(const std::string& token);
+static RpnStatus	applyReference(const std::string& token, int pops,
+						std::vector<long long>& stack);
+static RpnStatus	powerReference(long long base, long long exponent,
+						long long& result);
+static Outcome		evaluateProgram(RpnProgram& program,
+						std::vector<int>& stack, const std::string& expression);
+static bool			sameOutcome(const Outcome& a, const Outcome& b);
+static void			showOutcome(const char* label, const Outcome& outcome);
+
+// tokens mixed into the generated expressions
+static const char*	g_pool[] = {
+	"+", "-", "*", "/", "%", "pow", "min", "max", "neg", "dup", "swap",
+	"drop", "sum1", "sum2", "sum3", "sum9", "sum0", "sum", "sum+2", "0", "1",
+	"-1", "2", "7", "+3", "007", "-0", "2147483647", "-2147483648",
+	"2147483648", "-2147483649", "46341", "65536", "x", "1.5", "++", "--",
+	"(", "abc", "3x", "\x7f"
+};
+
+static const char*	g_separators[] = {" ", "  ", "\t", " \n ", "\r\v\f"};
+
+static const char*	g_binary[] = {
+	"+", "-", "*", "/", "%", "pow", "min", "max", NULL
+};
+
+static const char*	g_classes[] = {
+	"ok", "too many operators", "range", "division by zero", "remainder",
+	"missing operator", "invalid token"
+};
+
+// --- main function ---
+int	main(int ac, char** av)
+{
+	if (ac != 3)
+	{
+		std::cerr << "usage: rpn_fuzz <cases> <seed>" << std::endl;
+		return (NOK);
+	}
+
+	size_t				cases = std::strtoul(av[1], NULL, 10);
+	uint64_t			state = std::strtoul(av[2], NULL, 10) | 1;
+	size_t				counts[RPN_INVALID_TOKEN + 1] = {0};
+	size_t				mismatches = 0;
+	RpnProgram			program;
+	std::vector<int>	stack;
+	std::string			expression;
+
+	for (size_t i = 0; i < cases; i++)
+	{
+		expression.clear();
+		generateCase(expression, state);
+
+		Outcome	expected = evaluateReference(expression);
+		Outcome	got = evaluateProgram(program, stack, expression);
+
+		counts[expected.status]++;
+		if (sameOutcome(expected, got))
+			continue;
+		if (++mismatches <= FUZZ_SHOWN)
+		{
+			std::cout << "mismatch on \"" << expression << "\"" << std::endl;
+			showOutcome("expected", expected);
+			showOutcome("got", got);
+		}
+	}
+
+	std::cout << "cases: " << cases << ", mismatches: " << mismatches
+		<< std::endl;
+	for (int i = RPN_OK; i <= RPN_INVALID_TOKEN; i++)
+		std::cout << "  " << g_classes[i] << ": " << counts[i] << std::endl;
+	return (mismatches ? NOK : OK);
+}
+
+
+
+
+
+// --- helper functions definition ---
+// Half the cases are well formed expressions with boundary sized
+// literals, half of those then have a token inserted, dropped or
+// replaced; the rest are up to 8 tokens from the pool. Tokens are joined
+// by assorted blanks.
+static void	generateCase(std::string& out, uint64_t& state)
+{
+	static const long long		literals[] = {9, 1000, 46341, INT_MAX};
+	size_t						pool = sizeof(g_pool) / sizeof(g_pool[0]);
+	std::vector<std::string>	tokens;
+	std::string					word;
+
+	if (randomBelow(state, 2) == 0)
+	{
+		std::string	text;
+
+		appendExpression(text, state, 1 + randomBelow(state, 15),
+			2 + randomBelow(state, 5), g_binary, literals[randomBelow(state, 4)]);
+		std::istringstream	split(text);
+		while (split >> word)
+			tokens.push_back(word);
+		if (randomBelow(state, 2) == 0)
+		{
+			size_t	at = randomBelow(state, tokens.size() + 1);
+			size_t	action = randomBelow(state, 3);
+
+			if (action == 0 || at == tokens.size())
+				tokens.insert(tokens.begin() + at, g_pool[randomBelow(state, pool)]);
+			else if (action == 1)
+				tokens.erase(tokens.begin() + at);
+			else
+				tokens[at] = g_pool[randomBelow(state, pool)];
+		}
+	}
+	else
+	{
+		for (size_t count = randomBelow(state, 9); count > 0; count--)
+			tokens.push_back(g_pool[randomBelow(state, pool)]);
+	}
+
+	if (randomBelow(state, 4) == 0)
+		out += g_separators[randomBelow(state, 5)];
+	for (size_t i = 0; i < tokens.size(); i++)
+	{
+		if (i > 0)
+			out += (randomBelow(state, 4) == 0)
+				? g_separators[randomBelow(state, 5)] : " ";
+		out += tokens[i];
+	}
+	if (randomBelow(state, 4) == 0)
+		out += g_separators[randomBelow(state, 5)];
+}
+
+// left to right on a stack of long long, every result checked against the
+// int range; the first error ends the evaluation
+static Outcome	evaluateReference(const std::string& expression)
+{
+	Outcome					outcome = {RPN_OK, 0, RPN_NO_OFFSET};
+	std::vector<long long>	stack;
+	bool					has_operator = false;
+	size_t					emptied = RPN_NO_OFFSET;
+	size_t					i = 0;
+
+	while (i < expression.size())
+	{
+		if (std::isspace(static_cast<unsigned char>(expression[i])))
+		{
+			i++;
+			continue;
+		}
+
+		size_t		start = i;
+		int			value;
+		int			pops;
+
+		while (i < expression.size()
+			&& !std::isspace(static_cast<unsigned char>(expression[i])))
+			i++;
+
+		std::string	token = expression.substr(start, i - start);
+
+		if (referenceValue(token, value))
+		{
+			stack.push_back(value);
+			continue;
+		}
+		pops = referencePops(token);
+		if (pops < 0 || static_cast<size_t>(pops) > stack.size())
+		{
+			outcome.status = pops < 0 ? RPN_INVALID_TOKEN : RPN_OPERATOR_ERROR;
+			outcome.offset = start;
+			return (outcome);
+		}
+		has_operator = true;
+		outcome.status = applyReference(token, pops, stack);
+		if (outcome.status != RPN_OK)
+			return (outcome);
+		if (stack.empty())
+			emptied = start;
+	}
+
+	if (!has_operator)
+		outcome.status = RPN_MISSING_OPERATOR;
+	else if (stack.size() > 1)
+		outcome.status = RPN_REMAINDER;
+	else if (stack.empty())
+	{
+		outcome.status = RPN_OPERATOR_ERROR;
+		outcome.offset = emptied;
+	}
+	else
+		outcome.value = stack[0];
+	return (outcome);
+}
+
+// the original parser: operator>> into an int, with nothing left over
+static bool	referenceValue(const std::string& token, int& value)
+{
+	std::istringstream	parse(token);
+	char				rest;
+
+	return ((parse >> value) && !(parse >> rest));
+}
+
+// how many values the operator takes off the stack; -1 when the token is
+// none
+static int	referencePops(const std::string& token)
+{
+	int	count;
+
+	for (size_t i = 0; g_binary[i]; i++)
+	{
+		if (token == g_binary[i])
+			return (2);
+	}
+	if (token == "neg" || token == "dup" || token == "drop")
+		return (1);
+	if (token == "swap")
+		return (2);
+	if (token.size() > 3 && !token.compare(0, 3, "sum")
+		&& std::isdigit(static_cast<unsigned char>(token[3]))
+		&& referenceValue(token.substr(3), count) && count > 0)
+		return (count);
+	return (-1);
+}
+
+static RpnStatus	applyReference(const std::string& token, int pops,
+						std::vector<long long>& stack)
+{
+	long long	b = stack.back();
+	long long	a = (pops > 1) ? stack[stack.size() - 2] : 0;
+	long long	result = 0;
+	RpnStatus	status = RPN_OK;
+
+	if (token == "dup")
+		stack.push_back(b);
+	else if (token == "swap")
+		std::swap(stack[stack.size() - 1], stack[stack.size() - 2]);
+	else if (token == "drop")
+		stack.pop_back();
+	else if (token == "neg")
+		stack.back() = -b;
+	else if (!token.compare(0, 3, "sum"))
+	{
+		result = stack[stack.size() - pops];
+		for (size_t i = stack.size() - pops + 1; i < stack.size(); i++)
+		{
+			result += stack[i];
+			if (result < INT_MIN || result > INT_MAX)
+				return (RPN_RANGE_ERROR);
+		}
+		stack.resize(stack.size() - pops + 1);
+		stack.back() = result;
+	}
+	else
+	{
+		if ((token == "/" || token == "%") && b == 0)
+			return (RPN_DIVISION_BY_ZERO);
+		if (token == "+")
+			result = a + b;
+		else if (token == "-")
+			result = a - b;
+		else if (token == "*")
+			result = a * b;
+		else if (token == "/")
+			result = a / b;
+		else if (token == "%")
+			result = a % b;
+		else if (token == "min")
+			result = a < b ? a : b;
+		else if (token == "max")
+			result = a > b ? a : b;
+		else
+			status = powerReference(a, b, result);
+		stack.pop_back();
+		stack.back() = result;
+	}
+	if (status == RPN_OK && (stack.back() < INT_MIN || stack.back() > INT_MAX))
+		status = RPN_RANGE_ERROR;
+	return (status);
+}
+
+// repeated multiplication, stopped as soon as the int range is left
+static RpnStatus	powerReference(long long base, long long exponent,
+						long long& result)
+{
+	if (exponent < 0)
+	{
+		if (base == 0)
+			return (RPN_DIVISION_BY_ZERO);
+		if (base == 1 || base == -1)
+			result = (base == -1 && exponent % 2) ? -1 : 1;
+		else
+			result = 0;
+		return (RPN_OK);
+	}
+	result = 1;
+	if ((base == 0 || base == 1) && exponent > 0)
+		result = base;
+	else if (base == -1)
+		result = (exponent % 2) ? -1 : 1;
+	if (base >= -1 && base <= 1)
+		return (RPN_OK);
+	for (long long i = 0; i < exponent; i++)
+	{
+		result *= base;
+		if (result < INT_MIN || result > INT_MAX)
+			return (RPN_RANGE_ERROR);
+	}
+	return (RPN_OK);
+}
+
+static Outcome	evaluateProgram(RpnProgram& program, std::vector<int>& stack,
+					const std::string& expression)
+{
+	Outcome	outcome = {RPN_OK, 0, RPN_NO_OFFSET};
+	int		result = 0;
+
+	program.compile(expression);
+	if (stack.size() <= program.maxDepth())
+		stack.resize(program.maxDepth() + 1);
+	outcome.status = program.run(&stack[0], result);
+	outcome.value = result;
+	if (outcome.status == RPN_INVALID_TOKEN
+		|| outcome.status == RPN_OPERATOR_ERROR)
+		outcome.offset = program.errorOffset();
+	return (outcome);
+}
+
+static bool	sameOutcome(const Outcome& a, const Outcome& b)
+{
+	if (a.status != b.status)
+		return (false);
+	if (a.status == RPN_OK)
+		return (a.value == b.value);
+	return (a.offset == b.offset);
+}
+
+static void	showOutcome(const char* label, const Outcome& outcome)
+{
+	std::cout << "  " << label << ": " << g_classes[outcome.status];
+	if (outcome.status == RPN_OK)
+		std::cout << " " << outcome.value;
+	if (outcome.offset != RPN_NO_OFFSET)
+		std::cout << " at byte " << outcome.offset;
+	std::cout << std::endl;
+}
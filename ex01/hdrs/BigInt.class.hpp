@@ -0,0 +1,75 @@
+#ifndef BIGINT_CLASS_HPP
+#define BIGINT_CLASS_HPP
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "LimbPool.class.hpp"
+
+// operands with fewer limbs than this are multiplied schoolbook; at least
+// 4, below which Karatsuba's half-size products are no smaller
+#define KARATSUBA_THRESHOLD 32
+
+// values with fewer limbs than this are printed by repeated division by
+// 10^9; larger ones are first split in halves by powers 10^(9 * 2^k)
+#define DECIMAL_SPLIT_THRESHOLD 64
+
+// divisors with fewer limbs than this get their reciprocal from a long
+// division; larger ones from a Newton step on a half-size reciprocal
+#define RECIPROCAL_THRESHOLD 64
+
+// Sign-magnitude integer of any size: little-endian 32-bit limbs, no
+// leading zero limb, zero is never negative. Limb buffers come from and go
+// back to a LimbPool: every operation builds its result in a fresh pool
+// buffer and hands the old one back, so the result may be one of its
+// operands and a stack of BigInts reuses the same few buffers.
+class BigInt
+{
+	public:
+		explicit BigInt(LimbPool& pool);
+		BigInt(const BigInt& old_obj);
+		BigInt& operator=(const BigInt& old_obj);
+		~BigInt();
+
+		void		assign(long long value);
+		void		negate();
+		void		swap(BigInt& other);
+		bool		isZero() const;
+		bool		isOdd() const;
+		int			sign() const;
+		bool		toLongLong(long long& value) const;
+		void		appendTo(std::string& out) const;
+		std::string	toString() const;
+
+		static int	compare(const BigInt& a, const BigInt& b);
+		static void	add(const BigInt& a, const BigInt& b, BigInt& out);
+		static void	sub(const BigInt& a, const BigInt& b, BigInt& out);
+		static void	mul(const BigInt& a, const BigInt& b, BigInt& out);
+		static bool	div(const BigInt& a, const BigInt& b, BigInt& out);
+		static bool	mod(const BigInt& a, const BigInt& b, BigInt& out);
+		static void	pow(const BigInt& base, unsigned long exponent, BigInt& out);
+
+	private:
+		static void	addSigned(const BigInt& a, const BigInt& b,
+						bool b_negative, BigInt& out);
+		static int	compareMagnitude(const BigInt& a, const BigInt& b);
+		static void	shiftLimbs(const BigInt& a, long count, BigInt& out);
+		static void	reciprocal(const BigInt& d, BigInt& out);
+		static void	divBarrett(const BigInt& a, const BigInt& d,
+						const BigInt& inverse, BigInt& quotient, BigInt& rest);
+		static void	appendDecimal(std::string& out, const BigInt& value,
+						const std::vector<BigInt>& powers,
+						const std::vector<BigInt>& inverses, size_t level,
+						size_t width);
+		void		appendChunks(std::string& out, size_t width) const;
+		void		take(LimbBuffer* limbs, bool negative);
+
+		LimbPool*	_pool;
+		LimbBuffer*	_limbs;
+		size_t		_size;
+		bool		_negative;
+};
+
+#endif // #ifndef BIGINT_CLASS_HPP
@@ -0,0 +1,34 @@
+#ifndef LIMBPOOL_CLASS_HPP
+#define LIMBPOOL_CLASS_HPP
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+typedef std::vector<uint32_t>	LimbBuffer;
+
+// Free list of limb buffers shared by the BigInts of one evaluator:
+// released buffers keep their capacity and are handed out again, so once
+// the pool has grown to the working set, BigInt arithmetic stops
+// allocating. Not thread safe; one pool per thread.
+class LimbPool
+{
+	public:
+		LimbPool();
+		~LimbPool();
+
+		LimbBuffer*	acquire(size_t limbs);
+		void		release(LimbBuffer* buffer);
+		size_t		created() const;
+		size_t		reused() const;
+
+	private:
+		LimbPool(const LimbPool& old_obj);
+		LimbPool& operator=(const LimbPool& old_obj);
+
+		std::vector<LimbBuffer*>	_free;
+		size_t						_created;
+		size_t						_reused;
+};
+
+#endif // #ifndef LIMBPOOL_CLASS_HPP
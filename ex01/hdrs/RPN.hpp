@@ -1,15 +1,16 @@
 #ifndef RPN_HPP
 #define RPN_HPP
 
-#include <climits>
 #include <iostream>
-#include <sstream>
-#include <stack>
 #include <string>
+#include <vector>
 
 #include "colors.hpp"
 #include "dictionary.hpp"
+#include "RpnCache.class.hpp"
+#include "RpnProgram.class.hpp"
 
-int	RPN(const std::string& expression);
+int	RPN(const std::string& expression, RpnMode mode = RPN_MODE_INT,
+		bool bignum = false, RpnCache* cache = NULL);
 
 #endif // #ifndef RPN_HPP
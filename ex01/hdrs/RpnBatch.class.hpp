@@ -0,0 +1,90 @@
+#ifndef RPNBATCH_CLASS_HPP
+#define RPNBATCH_CLASS_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "RpnCache.class.hpp"
+#include "RpnProgram.class.hpp"
+
+// Evaluates one expression per input line and writes one output line per
+// expression, in input order: the result, or "Error: <message>". Input is
+// read in BATCH_CHUNK blocks per worker and cut on newlines; every worker
+// keeps its own program, stack and output buffer across lines, so after
+// warm-up no expression allocates. With one thread the lines are
+// evaluated on the calling thread. Lines are compiled for one RpnMode; in
+// bignum mode a line whose result leaves the mode's range is evaluated
+// again with the worker's BigInt stack, whose limb buffers are recycled
+// from line to line. With a cache limit, every worker keeps an RpnCache of
+// its share of the limit, and a line seen before is answered from it.
+class RpnBatch
+{
+	public:
+		RpnBatch(int in_fd, int out_fd, size_t threads,
+			RpnMode mode = RPN_MODE_INT, bool bignum = false,
+			size_t cache_limit = 0);
+		~RpnBatch();
+
+		int		run();
+		bool	writeFailed() const;
+		size_t	lines() const;
+		size_t	errors() const;
+		size_t	cacheHits() const;
+		size_t	cacheMisses() const;
+		size_t	cacheEvictions() const;
+
+	private:
+		// one worker's slice of a round and everything it reuses
+		struct Job
+		{
+			Job();
+			~Job();
+
+			const char*				data;
+			size_t					len;
+			RpnMode					mode;
+			bool					bignum;
+			RpnProgram				program;
+			std::vector<int>		stack;
+			std::vector<long long>	wideStack;
+			std::vector<double>		realStack;
+			LimbPool				pool;
+			std::vector<BigInt>		bigStack;
+			BigInt					bigResult;
+			RpnCache*				cache;
+			std::string				out;
+			size_t					lines;
+			size_t					errors;
+		};
+
+		RpnBatch();
+		RpnBatch(const RpnBatch& old_obj);
+		RpnBatch& operator=(const RpnBatch& old_obj);
+
+		static void			processChunk(void* arg);
+		static void			evaluateLine(Job& job, const char* begin,
+								const char* end);
+		static RpnStatus	evaluate(Job& job, const char* begin,
+								const char* end);
+		static RpnStatus	evaluateInt(Job& job);
+		static RpnStatus	evaluateWide(Job& job);
+		static RpnStatus	evaluateReal(Job& job);
+		static RpnStatus	evaluateBig(Job& job);
+		bool				writeOut(const std::string& out);
+
+		int		_inFd;
+		int		_outFd;
+		size_t	_threads;
+		RpnMode	_mode;
+		bool	_bignum;
+		size_t	_cacheLimit;
+		bool	_writeFailed;
+		size_t	_lines;
+		size_t	_errors;
+		size_t	_cacheHits;
+		size_t	_cacheMisses;
+		size_t	_cacheEvictions;
+};
+
+#endif // #ifndef RPNBATCH_CLASS_HPP
@@ -0,0 +1,81 @@
+#ifndef RPNCACHE_CLASS_HPP
+#define RPNCACHE_CLASS_HPP
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "RpnProgram.class.hpp"
+
+// buckets of an empty cache; the table doubles as entries are added
+#define RPN_CACHE_BUCKETS 256
+
+// Outcomes of whole expressions, keyed by their text and a tag telling
+// apart the ways they were evaluated (mode, bignum): the status, and the
+// text the caller printed for it, its result or its error. Keys are
+// hashed with 64-bit FNV-1a into a chained table, and the entries form a
+// list from most to least recently used: inserting past the memory limit
+// evicts from its tail. Evicted entries are reused with their string
+// buffers, so once the cache is full it no longer allocates. Not thread
+// safe; one cache per thread.
+class RpnCache
+{
+	public:
+		explicit RpnCache(size_t limit);
+		~RpnCache();
+
+		const std::string*	find(const char* begin, const char* end, int tag,
+								RpnStatus& status);
+		void				insert(const char* begin, const char* end, int tag,
+								RpnStatus status, const char* result, size_t len);
+		size_t				hits() const;
+		size_t				misses() const;
+		size_t				evictions() const;
+		size_t				entries() const;
+		size_t				bytes() const;
+		size_t				limit() const;
+
+	private:
+		// chain links the bucket, or the free list once evicted
+		struct Entry
+		{
+			uint64_t	hash;
+			std::string	key;
+			std::string	result;
+			RpnStatus	status;
+			int			tag;
+			size_t		chain;
+			size_t		newer;
+			size_t		older;
+		};
+
+		static const size_t	NONE = static_cast<size_t>(-1);
+
+		RpnCache();
+		RpnCache(const RpnCache& old_obj);
+		RpnCache& operator=(const RpnCache& old_obj);
+
+		static uint64_t	hashKey(const char* begin, const char* end, int tag);
+		static size_t	entryBytes(size_t key, size_t result);
+		size_t			lookup(uint64_t hash, const char* begin,
+							const char* end, int tag) const;
+		void			unlink(size_t index);
+		void			linkNewest(size_t index);
+		void			evictOldest();
+		void			grow();
+
+		std::vector<Entry>	_entries;
+		std::vector<size_t>	_buckets;
+		size_t				_free;
+		size_t				_newest;
+		size_t				_oldest;
+		size_t				_count;
+		size_t				_bytes;
+		size_t				_limit;
+		size_t				_hits;
+		size_t				_misses;
+		size_t				_evictions;
+};
+
+#endif // #ifndef RPNCACHE_CLASS_HPP
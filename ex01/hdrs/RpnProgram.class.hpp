@@ -0,0 +1,206 @@
+#ifndef RPNPROGRAM_CLASS_HPP
+#define RPNPROGRAM_CLASS_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "BigInt.class.hpp"
+
+// rows per block in runColumns()
+#define RPN_BLOCK 256
+
+// slots of the table of folded operations kept by each program
+#define RPN_FOLD_MEMO 64
+
+// errorOffset() of a program that did not stop on a token
+#define RPN_NO_OFFSET static_cast<size_t>(-1)
+
+// largest pow exponent runBig() expands; past it the result is reported
+// out of range rather than taking all memory. 2^17: INT_MAX to this power
+// is about 1.2 million digits, computed and printed in seconds
+#define RPN_BIG_POW_MAX 131072
+
+// how an evaluation ended, one per error message of RPN()
+enum RpnStatus
+{
+	RPN_OK,
+	RPN_OPERATOR_ERROR,
+	RPN_RANGE_ERROR,
+	RPN_DIVISION_BY_ZERO,
+	RPN_REMAINDER,
+	RPN_MISSING_OPERATOR,
+	RPN_INVALID_TOKEN
+};
+
+// number type of a compiled expression; the template and column paths
+// are int only
+enum RpnMode
+{
+	RPN_MODE_INT,
+	RPN_MODE_I64,
+	RPN_MODE_FLOAT
+};
+
+// dense, so the dispatch switches compile to jump tables
+enum RpnOpcode
+{
+	OP_PUSH,
+	OP_PUSH_WIDE,
+	OP_PUSH_REAL,
+	OP_LOAD,
+	OP_ADD,
+	OP_SUB,
+	OP_MUL,
+	OP_DIV,
+	OP_MOD,
+	OP_POW,
+	OP_MIN,
+	OP_MAX,
+	OP_NEG,
+	OP_DUP,
+	OP_SWAP,
+	OP_DROP,
+	OP_SUM,
+	OP_RETURN,
+	OP_FAIL
+};
+
+// operand is the constant of OP_PUSH, the constant pool index of
+// OP_PUSH_WIDE and OP_PUSH_REAL, the variable of OP_LOAD, the count of
+// OP_SUM and the RpnStatus of OP_FAIL
+struct RpnInstruction
+{
+	RpnOpcode	opcode;
+	int			operand;
+};
+
+// One entry of the operator registry: the token, how many values it takes
+// off the stack and how many it puts back. A pops of 0 marks a counted
+// operator, spelt as the token followed by its count (sum3).
+struct RpnOperator
+{
+	const char*	token;
+	RpnOpcode	opcode;
+	int			pops;
+	int			pushes;
+};
+
+// one binary operation on constants and what it folded to
+struct RpnFold
+{
+	RpnOpcode	opcode;
+	int			lhs;
+	int			rhs;
+	int			result;
+};
+
+// An expression compiled once into bytecode and run any number of times.
+// compile() parses every constant and checks the stack depth of every
+// operator ahead of time; an expression that cannot succeed compiles up to
+// the offending token followed by OP_FAIL, so errors raised earlier at run
+// time (division by zero, range) are still reported first, as RPN() always
+// did; errorOffset() tells where in the source the offending token starts.
+// The source is scanned in place, one token at a time, without copying
+// it. Operators come from a registry (see rpnOperators()), so a token is
+// matched and its stack arity checked in one table lookup.
+//
+// An expression compiled for RPN_MODE_I64 or RPN_MODE_FLOAT keeps literals
+// that do not fit an int in a constant pool and runs with the long long or
+// double overload of run(); every run() needs a stack of at least
+// maxDepth() values of its type. Compiling into the same program again
+// reuses its buffers, so once they have grown to the largest expression
+// seen, compile() no longer allocates.
+//
+// Outside RPN_MODE_FLOAT, an operator whose operands are all constants is
+// evaluated while compiling and replaced by pushes of its results, so a
+// constant sub-tree costs nothing at run time and an expression without
+// variables compiles to a single push. Only operators that succeed are
+// folded; one that fails stays in the code, with the constants it was
+// given, for run() to report in order. Folded binary operations are also
+// kept in a small table, so a sub-tree that recurs, in the same expression
+// or in a later one, is evaluated once.
+//
+// compileTemplate() also accepts variable names ([A-Za-z_][A-Za-z0-9_]*),
+// numbered in order of first use (variables()). A template runs on one set
+// of values with run(), or over whole columns with runColumns(), which
+// executes each opcode across RPN_BLOCK rows at a time and records every
+// row's first error in a status array instead of stopping; it needs a
+// workspace of workspaceSize() ints.
+//
+// runBig() runs the same code on BigInts, for the bignum mode: only
+// division by zero and the compile-time errors remain. Callers run the int
+// or i64 path first and only fall back to runBig() when it reports a range
+// error, so expressions that fit never touch a BigInt.
+class RpnProgram
+{
+	public:
+		RpnProgram();
+		~RpnProgram();
+
+		void		compile(const std::string& expression,
+						RpnMode mode = RPN_MODE_INT);
+		void		compile(const char* begin, const char* end,
+						RpnMode mode = RPN_MODE_INT);
+		void		compileTemplate(const char* begin, const char* end);
+		RpnStatus	run(int* stack, int& result, const int* values = NULL) const;
+		RpnStatus	run(long long* stack, long long& result) const;
+		RpnStatus	run(double* stack, double& result) const;
+		RpnStatus	runBig(BigInt* stack, BigInt& result,
+						const int* values = NULL) const;
+		void		runColumns(const int* const* columns, size_t rows,
+						int* results, unsigned char* status, int* workspace) const;
+		size_t		maxDepth() const;
+		size_t		workspaceSize() const;
+		size_t		size() const;
+		size_t		errorOffset() const;
+
+		const std::vector<std::string>&	variables() const;
+
+	private:
+		RpnProgram(const RpnProgram& old_obj);
+		RpnProgram& operator=(const RpnProgram& old_obj);
+
+		void		compileTokens(const char* begin, const char* end,
+						bool variables, RpnMode mode);
+		bool		compileValue(const char* begin, const char* end,
+						RpnMode mode);
+		bool		foldOperator(RpnOpcode opcode, int operand, int pops,
+						int pushes);
+		void		emit(RpnOpcode opcode, int operand);
+		int			variableIndex(const char* begin, const char* end);
+		RpnStatus	runExtended(const RpnInstruction* ip, int* top,
+						int& result, const int* values) const;
+		void		runBlock(const int* const* columns, size_t first,
+						size_t count, int* results, unsigned char* status,
+						int* workspace) const;
+
+		std::vector<RpnInstruction>	_code;
+		size_t						_maxDepth;
+		size_t						_errorOffset;
+		std::vector<std::string>	_variables;
+		std::vector<long long>		_integers;
+		std::vector<double>			_reals;
+		std::vector<int>			_foldStack;
+		RpnFold						_folds[RPN_FOLD_MEMO];
+};
+
+const RpnOperator*	rpnOperators();
+
+bool		parseRpnValue(const char* begin, const char* end, int& value);
+bool		parseRpnWide(const char* begin, const char* end, long long& value);
+bool		parseRpnReal(const char* begin, const char* end, double& value);
+const char*	rpnErrorMessage(RpnStatus status, RpnMode mode = RPN_MODE_INT);
+void		appendRpnError(std::string& out, RpnStatus status,
+				size_t offset = RPN_NO_OFFSET, RpnMode mode = RPN_MODE_INT);
+void		appendRpnInteger(std::string& out, long long value);
+void		appendRpnReal(std::string& out, double value);
+void		appendRpnResult(std::string& out, RpnStatus status, int result,
+				size_t offset = RPN_NO_OFFSET, RpnMode mode = RPN_MODE_INT);
+void		appendRpnResult(std::string& out, RpnStatus status, long long result,
+				size_t offset = RPN_NO_OFFSET, RpnMode mode = RPN_MODE_INT);
+void		appendRpnResult(std::string& out, RpnStatus status, double result,
+				size_t offset = RPN_NO_OFFSET);
+void		appendRpnResult(std::string& out, const BigInt& result);
+
+#endif // #ifndef RPNPROGRAM_CLASS_HPP
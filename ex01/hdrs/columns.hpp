@@ -0,0 +1,8 @@
+#ifndef COLUMNS_HPP
+#define COLUMNS_HPP
+
+#include <string>
+
+int	RPNColumns(const char* path, const std::string& expression);
+
+#endif // #ifndef COLUMNS_HPP
@@ -4,6 +4,8 @@
 #define OK 0
 #define NOK 1
 #define ERROR -1
-#define ERROR_LL (static_cast<long long>(INT_MAX) + 1)
+
+#define BATCH_CHUNK (1UL << 20)
+#define THREADS_MAX 256
 
 #endif // #ifndef DICTIONARY_HPP
@@ -0,0 +1,736 @@
+#include <algorithm>
+#include <climits>
+
+#include "BigInt.class.hpp"
+
+// --- helper functions declaration ---
+static uint32_t*	limbData(LimbBuffer* buffer);
+static size_t		trimmed(const uint32_t* a, size_t n);
+static uint32_t		addLimbs(uint32_t* r, const uint32_t* a, size_t an,
+						const uint32_t* b, size_t bn);
+static void			subLimbs(uint32_t* r, const uint32_t* a, size_t an,
+						const uint32_t* b, size_t bn);
+static void			addInPlace(uint32_t* r, size_t rn, const uint32_t* a, size_t an);
+static void			subInPlace(uint32_t* r, size_t rn, const uint32_t* a, size_t an);
+static void			mulLimbs(const uint32_t* a, size_t an, const uint32_t* b,
+						size_t bn, uint32_t* r, LimbPool& pool);
+static void			mulSchoolbook(const uint32_t* a, size_t an, const uint32_t* b,
+						size_t bn, uint32_t* r);
+static void			mulKaratsuba(const uint32_t* a, size_t an, const uint32_t* b,
+						size_t bn, uint32_t* r, LimbPool& pool);
+static void			divLimbs(const uint32_t* u, size_t un, const uint32_t* v,
+						size_t vn, uint32_t* q, uint32_t* r, LimbPool& pool);
+static uint32_t		divSmall(uint32_t* a, size_t n, uint32_t d);
+
+// --- constructors / destructor ---
+BigInt::BigInt(LimbPool& pool)
+	: _pool(&pool), _limbs(NULL), _size(0), _negative(false)
+{
+
+}
+
+BigInt::BigInt(const BigInt& old_obj)
+	: _pool(old_obj._pool), _limbs(NULL), _size(0), _negative(false)
+{
+	*this = old_obj;
+}
+
+BigInt& BigInt::operator=(const BigInt& old_obj)
+{
+	if (this != &old_obj)
+	{
+		LimbBuffer*	limbs = _pool->acquire(old_obj._size);
+		uint32_t*	source = limbData(old_obj._limbs);
+
+		std::copy(source, source + old_obj._size, limbData(limbs));
+		take(limbs, old_obj._negative);
+	}
+	return (*this);
+}
+
+BigInt::~BigInt()
+{
+	_pool->release(_limbs);
+}
+
+
+
+
+
+// --- methods ---
+void	BigInt::assign(long long value)
+{
+	LimbBuffer*			limbs = _pool->acquire(2);
+	unsigned long long	magnitude = static_cast<unsigned long long>(value);
+
+	if (value < 0)
+		magnitude = 0 - magnitude;
+	(*limbs)[0] = static_cast<uint32_t>(magnitude);
+	(*limbs)[1] = static_cast<uint32_t>(magnitude >> 32);
+	take(limbs, value < 0);
+}
+
+void	BigInt::negate()
+{
+	_negative = !_negative && _size > 0;
+}
+
+// exchanges the buffers, no limb is copied
+void	BigInt::swap(BigInt& other)
+{
+	std::swap(_pool, other._pool);
+	std::swap(_limbs, other._limbs);
+	std::swap(_size, other._size);
+	std::swap(_negative, other._negative);
+}
+
+bool	BigInt::isZero() const
+{
+	return (_size == 0);
+}
+
+bool	BigInt::isOdd() const
+{
+	return (_size > 0 && ((*_limbs)[0] & 1));
+}
+
+int	BigInt::sign() const
+{
+	if (_size == 0)
+		return (0);
+	return (_negative ? -1 : 1);
+}
+
+// false when the value does not fit a long long
+bool	BigInt::toLongLong(long long& value) const
+{
+	unsigned long long	magnitude = 0;
+
+	if (_size > 2)
+		return (false);
+	for (size_t i = _size; i-- > 0; )
+		magnitude = (magnitude << 32) | (*_limbs)[i];
+	if (magnitude > static_cast<unsigned long long>(LLONG_MAX) + _negative)
+		return (false);
+	value = _negative ? static_cast<long long>(0 - magnitude)
+		: static_cast<long long>(magnitude);
+	return (true);
+}
+
+// Small values go straight to appendChunks(). Larger ones are split by
+// the powers 10^(9 * 2^k) up to the largest not above the value, each
+// with its reciprocal for divBarrett(): a quotient and a remainder per
+// level instead of one 10^9 chunk per pass over the whole value, which
+// keeps the conversion within a few multiplications of the value's size.
+void	BigInt::appendTo(std::string& out) const
+{
+	if (_size == 0)
+	{
+		out += '0';
+		return ;
+	}
+	if (_negative)
+		out += '-';
+	if (_size < DECIMAL_SPLIT_THRESHOLD)
+	{
+		appendChunks(out, 0);
+		return ;
+	}
+
+	BigInt				magnitude(*this);
+	std::vector<BigInt>	powers(1, BigInt(*_pool));
+
+	magnitude._negative = false;
+	powers[0].assign(1000000000);
+	while (powers.back()._size * 2 - 1 <= _size)
+	{
+		powers.push_back(BigInt(*_pool));
+		mul(powers[powers.size() - 2], powers[powers.size() - 2],
+			powers.back());
+		if (compareMagnitude(powers.back(), magnitude) > 0)
+		{
+			powers.pop_back();
+			break ;
+		}
+	}
+
+	std::vector<BigInt>	inverses(powers.size(), BigInt(*_pool));
+
+	for (size_t k = 0; k < powers.size(); k++)
+	{
+		if (powers[k]._size * 2 >= DECIMAL_SPLIT_THRESHOLD)
+			reciprocal(powers[k], inverses[k]);
+	}
+	appendDecimal(out, magnitude, powers, inverses, powers.size() - 1, 0);
+}
+
+std::string	BigInt::toString() const
+{
+	std::string	out;
+
+	appendTo(out);
+	return (out);
+}
+
+int	BigInt::compare(const BigInt& a, const BigInt& b)
+{
+	if (a._negative != b._negative)
+		return (a._negative ? -1 : 1);
+	return (a._negative ? compareMagnitude(b, a) : compareMagnitude(a, b));
+}
+
+void	BigInt::add(const BigInt& a, const BigInt& b, BigInt& out)
+{
+	addSigned(a, b, b._negative, out);
+}
+
+void	BigInt::sub(const BigInt& a, const BigInt& b, BigInt& out)
+{
+	addSigned(a, b, !b._negative, out);
+}
+
+void	BigInt::mul(const BigInt& a, const BigInt& b, BigInt& out)
+{
+	LimbBuffer*	limbs = a._pool->acquire(a._size + b._size);
+
+	mulLimbs(limbData(a._limbs), a._size, limbData(b._limbs), b._size,
+		limbData(limbs), *a._pool);
+	out.take(limbs, a._negative != b._negative);
+}
+
+// truncates toward zero, like int division; false on a zero divisor
+bool	BigInt::div(const BigInt& a, const BigInt& b, BigInt& out)
+{
+	if (b._size == 0)
+		return (false);
+	if (compareMagnitude(a, b) < 0)
+	{
+		out.take(a._pool->acquire(0), false);
+		return (true);
+	}
+
+	LimbBuffer*	limbs = a._pool->acquire(a._size - b._size + 1);
+
+	divLimbs(limbData(a._limbs), a._size, limbData(b._limbs), b._size,
+		limbData(limbs), NULL, *a._pool);
+	out.take(limbs, a._negative != b._negative);
+	return (true);
+}
+
+// the remainder of div(), with the sign of a; false on a zero divisor
+bool	BigInt::mod(const BigInt& a, const BigInt& b, BigInt& out)
+{
+	if (b._size == 0)
+		return (false);
+	if (compareMagnitude(a, b) < 0)
+	{
+		out = a;
+		return (true);
+	}
+
+	LimbBuffer*	quotient = a._pool->acquire(a._size - b._size + 1);
+	LimbBuffer*	limbs = a._pool->acquire(b._size);
+
+	divLimbs(limbData(a._limbs), a._size, limbData(b._limbs), b._size,
+		limbData(quotient), limbData(limbs), *a._pool);
+	a._pool->release(quotient);
+	out.take(limbs, a._negative);
+	return (true);
+}
+
+// exponentiation by squaring
+void	BigInt::pow(const BigInt& base, unsigned long exponent, BigInt& out)
+{
+	BigInt	square(base);
+	BigInt	result(*base._pool);
+
+	result.assign(1);
+	while (exponent > 0)
+	{
+		if (exponent & 1)
+			mul(result, square, result);
+		exponent >>= 1;
+		if (exponent > 0)
+			mul(square, square, square);
+	}
+	out.swap(result);
+}
+
+// a + b with b's sign replaced by b_negative, so sub() is add() of -b
+void	BigInt::addSigned(const BigInt& a, const BigInt& b, bool b_negative,
+			BigInt& out)
+{
+	if (a._negative == b_negative)
+	{
+		const BigInt&	big = a._size >= b._size ? a : b;
+		const BigInt&	small = a._size >= b._size ? b : a;
+		LimbBuffer*		limbs = a._pool->acquire(big._size + 1);
+
+		(*limbs)[big._size] = addLimbs(limbData(limbs), limbData(big._limbs),
+			big._size, limbData(small._limbs), small._size);
+		out.take(limbs, b_negative);
+		return ;
+	}
+
+	int	order = compareMagnitude(a, b);
+
+	if (order == 0)
+	{
+		out.take(a._pool->acquire(0), false);
+		return ;
+	}
+
+	const BigInt&	big = order > 0 ? a : b;
+	const BigInt&	small = order > 0 ? b : a;
+	LimbBuffer*		limbs = a._pool->acquire(big._size);
+
+	subLimbs(limbData(limbs), limbData(big._limbs), big._size,
+		limbData(small._limbs), small._size);
+	out.take(limbs, order > 0 ? a._negative : b_negative);
+}
+
+int	BigInt::compareMagnitude(const BigInt& a, const BigInt& b)
+{
+	if (a._size != b._size)
+		return (a._size < b._size ? -1 : 1);
+	for (size_t i = a._size; i-- > 0; )
+	{
+		if ((*a._limbs)[i] != (*b._limbs)[i])
+			return ((*a._limbs)[i] < (*b._limbs)[i] ? -1 : 1);
+	}
+	return (0);
+}
+
+// a * B^count for count >= 0, else a / B^-count truncated toward zero,
+// with B = 2^32: limbs copied at an offset, no arithmetic
+void	BigInt::shiftLimbs(const BigInt& a, long count, BigInt& out)
+{
+	size_t		drop = count < 0 ? static_cast<size_t>(-count) : 0;
+	size_t		pad = count > 0 ? static_cast<size_t>(count) : 0;
+	size_t		kept = a._size > drop ? a._size - drop : 0;
+	LimbBuffer*	limbs = a._pool->acquire(kept + (kept ? pad : 0));
+
+	if (kept > 0)
+		std::copy(limbData(a._limbs) + drop, limbData(a._limbs) + a._size,
+			limbData(limbs) + pad);
+	out.take(limbs, a._negative);
+}
+
+// out = floor(B^2m / d) for d of m limbs, B = 2^32. Past the threshold,
+// x = reciprocal of d's top h = m / 2 + 2 limbs, shifted by l = m - h
+// limbs, is within a relative B^(1 - h) of the answer, and one Newton
+// step x += x (B^2m - d x) / B^2m squares that error to under one unit.
+// The step only needs d times the unshifted x and the top half of
+// B^2m - d x, so both of its products are about half size; the last
+// adjustment against the exact remainder takes a step or two.
+void	BigInt::reciprocal(const BigInt& d, BigInt& out)
+{
+	size_t	m = d._size;
+	BigInt	power(*d._pool);
+	BigInt	one(*d._pool);
+
+	one.assign(1);
+	shiftLimbs(one, static_cast<long>(2 * m), power);
+	if (m < RECIPROCAL_THRESHOLD)
+	{
+		div(power, d, out);
+		return ;
+	}
+
+	long	h = static_cast<long>(m / 2 + 2);
+	long	l = static_cast<long>(m) - h;
+	BigInt	x(*d._pool);
+	BigInt	e(*d._pool);
+	BigInt	step(*d._pool);
+
+	shiftLimbs(d, -l, e);
+	reciprocal(e, x);
+	mul(d, x, e);
+	shiftLimbs(one, static_cast<long>(m) + h, step);
+	sub(step, e, e);
+	shiftLimbs(e, 2 - h, e);
+	mul(x, e, step);
+	shiftLimbs(x, l, x);
+	shiftLimbs(step, -(h + 2), step);
+	add(x, step, x);
+
+	mul(d, x, e);
+	sub(power, e, e);
+	while (e._negative)
+	{
+		sub(x, one, x);
+		add(e, d, e);
+	}
+	while (compareMagnitude(e, d) >= 0)
+	{
+		add(x, one, x);
+		sub(e, d, e);
+	}
+	out.swap(x);
+}
+
+// Barrett division of 0 <= a < B^2m by d of m limbs, inverse being
+// reciprocal(d): the estimate (a / B^(m-1)) inverse / B^(m+1) is at most
+// two below the quotient, so two multiplications and a correction or two
+// replace a long division.
+void	BigInt::divBarrett(const BigInt& a, const BigInt& d,
+			const BigInt& inverse, BigInt& quotient, BigInt& rest)
+{
+	long	m = static_cast<long>(d._size);
+	BigInt	one(*a._pool);
+
+	one.assign(1);
+	shiftLimbs(a, 1 - m, quotient);
+	mul(quotient, inverse, quotient);
+	shiftLimbs(quotient, -(m + 1), quotient);
+	mul(quotient, d, rest);
+	sub(a, rest, rest);
+	while (compareMagnitude(rest, d) >= 0)
+	{
+		sub(rest, d, rest);
+		add(quotient, one, quotient);
+	}
+}
+
+// Digits of 0 <= value < powers[level]^2, powers[k] being 10^(9 * 2^k),
+// left-padded with zeros to width unless width is 0: the quotient by
+// powers[level] gives the high half and the remainder the low half,
+// 9 * 2^level digits. Unpadded, the split starts at the largest power not
+// above value, so the high half never prints as a leading zero.
+void	BigInt::appendDecimal(std::string& out, const BigInt& value,
+			const std::vector<BigInt>& powers,
+			const std::vector<BigInt>& inverses, size_t level, size_t width)
+{
+	if (value._size < DECIMAL_SPLIT_THRESHOLD)
+	{
+		value.appendChunks(out, width);
+		return ;
+	}
+	while (width == 0 && compareMagnitude(powers[level], value) > 0)
+		level--;
+
+	BigInt	quotient(*value._pool);
+	BigInt	rest(*value._pool);
+	size_t	half = static_cast<size_t>(9) << level;
+
+	divBarrett(value, powers[level], inverses[level], quotient, rest);
+	appendDecimal(out, quotient, powers, inverses, level - 1,
+		width ? width - half : 0);
+	appendDecimal(out, rest, powers, inverses, level - 1, half);
+}
+
+// the magnitude in base 10^9 chunks, least significant first, taken off a
+// scratch copy, then written most significant first and padded to width
+void	BigInt::appendChunks(std::string& out, size_t width) const
+{
+	LimbBuffer*	scratch = _pool->acquire(_size);
+	LimbBuffer*	chunks = _pool->acquire(_size * 10 / 9 + 1);
+	size_t		n = _size;
+	size_t		count = 0;
+	size_t		mark = out.size();
+	char		digits[10];
+
+	if (_size > 0)
+		std::copy(limbData(_limbs), limbData(_limbs) + _size, limbData(scratch));
+	while (n > 0)
+	{
+		(*chunks)[count++] = divSmall(limbData(scratch), n, 1000000000u);
+		n = trimmed(limbData(scratch), n);
+	}
+
+	for (size_t i = count; i-- > 0; )
+	{
+		uint32_t	chunk = (*chunks)[i];
+		size_t		len = 0;
+
+		do
+		{
+			digits[sizeof(digits) - ++len] = static_cast<char>('0' + chunk % 10);
+			chunk /= 10;
+		} while (chunk > 0 || (i + 1 < count && len < 9));
+		out.append(digits + sizeof(digits) - len, len);
+	}
+	if (out.size() - mark < width)
+		out.insert(mark, width - (out.size() - mark), '0');
+	_pool->release(scratch);
+	_pool->release(chunks);
+}
+
+// adopts limbs as the new magnitude and gives the old buffer back
+void	BigInt::take(LimbBuffer* limbs, bool negative)
+{
+	_pool->release(_limbs);
+	_limbs = limbs;
+	_size = trimmed(limbData(limbs), limbs->size());
+	_negative = negative && _size > 0;
+}
+
+
+
+
+
+// --- helper functions definition ---
+static uint32_t*	limbData(LimbBuffer* buffer)
+{
+	if (!buffer || buffer->empty())
+		return (NULL);
+	return (&(*buffer)[0]);
+}
+
+static size_t	trimmed(const uint32_t* a, size_t n)
+{
+	while (n > 0 && a[n - 1] == 0)
+		n--;
+	return (n);
+}
+
+// r[0, an) = a + b for an >= bn; returns the carry out of the top limb
+static uint32_t	addLimbs(uint32_t* r, const uint32_t* a, size_t an,
+					const uint32_t* b, size_t bn)
+{
+	uint64_t	carry = 0;
+
+	for (size_t i = 0; i < an; i++)
+	{
+		carry += static_cast<uint64_t>(a[i]) + (i < bn ? b[i] : 0);
+		r[i] = static_cast<uint32_t>(carry);
+		carry >>= 32;
+	}
+	return (static_cast<uint32_t>(carry));
+}
+
+// r[0, an) = a - b for a >= b
+static void	subLimbs(uint32_t* r, const uint32_t* a, size_t an,
+				const uint32_t* b, size_t bn)
+{
+	uint64_t	borrow = 0;
+
+	for (size_t i = 0; i < an; i++)
+	{
+		uint64_t	diff = static_cast<uint64_t>(a[i]) - (i < bn ? b[i] : 0) - borrow;
+
+		r[i] = static_cast<uint32_t>(diff);
+		borrow = diff >> 63;
+	}
+}
+
+// r[0, rn) += a[0, an) for an <= rn, dropping the carry out of r
+static void	addInPlace(uint32_t* r, size_t rn, const uint32_t* a, size_t an)
+{
+	uint64_t	carry = 0;
+
+	for (size_t i = 0; i < rn && (i < an || carry); i++)
+	{
+		carry += static_cast<uint64_t>(r[i]) + (i < an ? a[i] : 0);
+		r[i] = static_cast<uint32_t>(carry);
+		carry >>= 32;
+	}
+}
+
+// r[0, rn) -= a[0, an) for an <= rn and r >= a
+static void	subInPlace(uint32_t* r, size_t rn, const uint32_t* a, size_t an)
+{
+	uint64_t	borrow = 0;
+
+	for (size_t i = 0; i < rn && (i < an || borrow); i++)
+	{
+		uint64_t	diff = static_cast<uint64_t>(r[i]) - (i < an ? a[i] : 0) - borrow;
+
+		r[i] = static_cast<uint32_t>(diff);
+		borrow = diff >> 63;
+	}
+}
+
+// r[0, an + bn) = a * b, r zeroed by the caller
+static void	mulLimbs(const uint32_t* a, size_t an, const uint32_t* b,
+				size_t bn, uint32_t* r, LimbPool& pool)
+{
+	if (an < bn)
+	{
+		std::swap(a, b);
+		std::swap(an, bn);
+	}
+	if (bn == 0)
+		return ;
+	if (bn < KARATSUBA_THRESHOLD)
+		mulSchoolbook(a, an, b, bn, r);
+	else
+		mulKaratsuba(a, an, b, bn, r, pool);
+}
+
+static void	mulSchoolbook(const uint32_t* a, size_t an, const uint32_t* b,
+				size_t bn, uint32_t* r)
+{
+	for (size_t j = 0; j < bn; j++)
+	{
+		uint64_t	carry = 0;
+
+		for (size_t i = 0; i < an; i++)
+		{
+			carry += static_cast<uint64_t>(a[i]) * b[j] + r[i + j];
+			r[i + j] = static_cast<uint32_t>(carry);
+			carry >>= 32;
+		}
+		r[an + j] = static_cast<uint32_t>(carry);
+	}
+}
+
+// For an >= bn >= KARATSUBA_THRESHOLD. Split at m = an / 2 into
+// a = a1 B^m + a0 and b = b1 B^m + b0; then a0 b0 and a1 b1 land side by
+// side in r and (a0 + a1)(b0 + b1) - a0 b0 - a1 b1 is added at B^m: three
+// half-size products instead of four. When b is too short to split, a is
+// cut into bn-limb slices, each a balanced product.
+static void	mulKaratsuba(const uint32_t* a, size_t an, const uint32_t* b,
+				size_t bn, uint32_t* r, LimbPool& pool)
+{
+	size_t	m = an / 2;
+
+	if (bn <= m)
+	{
+		LimbBuffer*	part = pool.acquire(2 * bn);
+
+		for (size_t off = 0; off < an; off += bn)
+		{
+			size_t	len = std::min(bn, an - off);
+
+			part->assign(len + bn, 0);
+			mulLimbs(a + off, len, b, bn, limbData(part), pool);
+			addInPlace(r + off, an + bn - off, limbData(part), len + bn);
+		}
+		pool.release(part);
+		return ;
+	}
+
+	size_t		b_high = bn - m;
+	size_t		sb_len = std::max(m, b_high);
+	LimbBuffer*	sa = pool.acquire(an - m + 1);
+	LimbBuffer*	sb = pool.acquire(sb_len + 1);
+
+	(*sa)[an - m] = addLimbs(limbData(sa), a + m, an - m, a, m);
+	if (b_high >= m)
+		(*sb)[sb_len] = addLimbs(limbData(sb), b + m, b_high, b, m);
+	else
+		(*sb)[sb_len] = addLimbs(limbData(sb), b, m, b + m, b_high);
+
+	LimbBuffer*	z1 = pool.acquire(sa->size() + sb->size());
+	size_t		z1_len = z1->size();
+
+	mulLimbs(a, m, b, m, r, pool);
+	mulLimbs(a + m, an - m, b + m, b_high, r + 2 * m, pool);
+	mulLimbs(limbData(sa), trimmed(limbData(sa), sa->size()), limbData(sb),
+		trimmed(limbData(sb), sb->size()), limbData(z1), pool);
+	subInPlace(limbData(z1), z1_len, r, 2 * m);
+	subInPlace(limbData(z1), z1_len, r + 2 * m, an + bn - 2 * m);
+	addInPlace(r + m, an + bn - m, limbData(z1), trimmed(limbData(z1), z1_len));
+	pool.release(sa);
+	pool.release(sb);
+	pool.release(z1);
+}
+
+// q[0, un - vn + 1) = u / v and, unless r is NULL, r[0, vn) = u % v, for
+// u >= v, v without leading zero limbs: Knuth's algorithm D on copies of u
+// and v shifted so v's top bit is set, which keeps every estimated
+// quotient digit at most two too large.
+static void	divLimbs(const uint32_t* u, size_t un, const uint32_t* v,
+				size_t vn, uint32_t* q, uint32_t* r, LimbPool& pool)
+{
+	const uint64_t	base = static_cast<uint64_t>(1) << 32;
+
+	if (vn == 1)
+	{
+		uint64_t	rem = 0;
+
+		for (size_t j = un; j-- > 0; )
+		{
+			uint64_t	cur = (rem << 32) | u[j];
+
+			q[j] = static_cast<uint32_t>(cur / v[0]);
+			rem = cur % v[0];
+		}
+		if (r)
+			r[0] = static_cast<uint32_t>(rem);
+		return ;
+	}
+
+	int			shift = __builtin_clz(v[vn - 1]);
+	LimbBuffer*	nv_buf = pool.acquire(vn);
+	LimbBuffer*	nu_buf = pool.acquire(un + 1);
+	uint32_t*	nv = limbData(nv_buf);
+	uint32_t*	nu = limbData(nu_buf);
+
+	for (size_t i = vn - 1; i > 0; i--)
+		nv[i] = (v[i] << shift) | static_cast<uint32_t>(
+			static_cast<uint64_t>(v[i - 1]) >> (32 - shift));
+	nv[0] = v[0] << shift;
+	nu[un] = static_cast<uint32_t>(static_cast<uint64_t>(u[un - 1]) >> (32 - shift));
+	for (size_t i = un - 1; i > 0; i--)
+		nu[i] = (u[i] << shift) | static_cast<uint32_t>(
+			static_cast<uint64_t>(u[i - 1]) >> (32 - shift));
+	nu[0] = u[0] << shift;
+
+	for (size_t j = un - vn + 1; j-- > 0; )
+	{
+		uint64_t	top = (static_cast<uint64_t>(nu[j + vn]) << 32) | nu[j + vn - 1];
+		uint64_t	qhat = top / nv[vn - 1];
+		uint64_t	rhat = top % nv[vn - 1];
+
+		while (qhat >= base
+			|| qhat * nv[vn - 2] > ((rhat << 32) | nu[j + vn - 2]))
+		{
+			qhat--;
+			rhat += nv[vn - 1];
+			if (rhat >= base)
+				break ;
+		}
+
+		int64_t	borrow = 0;
+		int64_t	t;
+
+		for (size_t i = 0; i < vn; i++)
+		{
+			uint64_t	p = qhat * nv[i];
+
+			t = static_cast<int64_t>(nu[i + j]) - borrow
+				- static_cast<int64_t>(p & 0xFFFFFFFFu);
+			nu[i + j] = static_cast<uint32_t>(t);
+			borrow = static_cast<int64_t>(p >> 32) - (t >> 32);
+		}
+		t = static_cast<int64_t>(nu[j + vn]) - borrow;
+		nu[j + vn] = static_cast<uint32_t>(t);
+
+		q[j] = static_cast<uint32_t>(qhat);
+		if (t < 0)
+		{
+			uint64_t	carry = 0;
+
+			q[j]--;
+			for (size_t i = 0; i < vn; i++)
+			{
+				carry += static_cast<uint64_t>(nu[i + j]) + nv[i];
+				nu[i + j] = static_cast<uint32_t>(carry);
+				carry >>= 32;
+			}
+			nu[j + vn] += static_cast<uint32_t>(carry);
+		}
+	}
+	for (size_t i = 0; r && i < vn; i++)
+		r[i] = (nu[i] >> shift) | static_cast<uint32_t>(
+			(static_cast<uint64_t>(nu[i + 1]) << 32) >> shift);
+	pool.release(nv_buf);
+	pool.release(nu_buf);
+}
+
+// a[0, n) /= d in place; returns the remainder
+static uint32_t	divSmall(uint32_t* a, size_t n, uint32_t d)
+{
+	uint64_t	rem = 0;
+
+	for (size_t i = n; i-- > 0; )
+	{
+		uint64_t	cur = (rem << 32) | a[i];
+
+		a[i] = static_cast<uint32_t>(cur / d);
+		rem = cur % d;
+	}
+	return (static_cast<uint32_t>(rem));
+}
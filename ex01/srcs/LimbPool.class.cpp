@@ -0,0 +1,55 @@
+#include "LimbPool.class.hpp"
+
+// --- constructors / destructor ---
+LimbPool::LimbPool()
+	: _created(0), _reused(0)
+{
+
+}
+
+LimbPool::~LimbPool()
+{
+	for (size_t i = 0; i < _free.size(); i++)
+		delete _free[i];
+}
+
+
+
+
+
+// --- methods ---
+// a zeroed buffer of exactly limbs limbs
+LimbBuffer*	LimbPool::acquire(size_t limbs)
+{
+	LimbBuffer*	buffer;
+
+	if (_free.empty())
+	{
+		buffer = new LimbBuffer();
+		_created++;
+	}
+	else
+	{
+		buffer = _free.back();
+		_free.pop_back();
+		_reused++;
+	}
+	buffer->assign(limbs, 0);
+	return (buffer);
+}
+
+void	LimbPool::release(LimbBuffer* buffer)
+{
+	if (buffer)
+		_free.push_back(buffer);
+}
+
+size_t	LimbPool::created() const
+{
+	return (_created);
+}
+
+size_t	LimbPool::reused() const
+{
+	return (_reused);
+}
@@ -1,55 +1,60 @@
 #include "RPN.hpp"
 
 // --- helper functions declaration ---
-static bool			isValidValue(const std::string& token, int& value);
-static int			handleOperator(const char oper, std::stack<int>& stack,
-									bool& check_operator);
-static bool			isValidOperator(char oper);
-static long long	doOperation(int value_1, int value_2, char oper);
-static void			rangeError();
-static void			operatorError();
-static void			remainderError();
-static void			divisionByZeroError();
-static void			missingOperatorError();
+static void			reportError(const std::string& message);
+static RpnStatus	runInt(const RpnProgram& program, std::string& result);
+static RpnStatus	runWide(const RpnProgram& program, std::string& result);
+static RpnStatus	runReal(const RpnProgram& program, std::string& result);
+static RpnStatus	runBig(const RpnProgram& program, std::string& result);
 
 // --- main function ---
-int	RPN(const std::string& expression)
+// With bignum, a result outside the mode's range is computed again with
+// BigInts. With a cache, an expression already evaluated the same way is
+// answered from it. The program, the stacks and the result text are kept
+// from call to call, so once they have grown to the largest expression
+// seen, a call allocates nothing; like std::cout, RPN() is for one thread
+// at a time.
+int	RPN(const std::string& expression, RpnMode mode, bool bignum,
+		RpnCache* cache)
 {
-	bool				check_operator = false;
-	std::stack<int>		stack;
-	std::istringstream	parsing_iss(expression);
-	std::string			token;
-
-	while (parsing_iss >> token)
+	static RpnProgram	program;
+	static std::string	result;
+	RpnStatus			status = RPN_OK;
+	const char*			begin = expression.data();
+	const char*			end = begin + expression.size();
+	int					tag = mode * 2 + bignum;
+	const std::string*	cached = NULL;
+
+	if (cache)
+		cached = cache->find(begin, end, tag, status);
+	if (cached)
+		result.assign(*cached);
+	else
 	{
-		int	value = 0;
-
-		if (isValidValue(token, value))
-			stack.push(value);
-		else if (token.size() == 1)
-		{
-			if (handleOperator(token[0], stack, check_operator) == ERROR)
-				return (ERROR);
-		}
+		result.clear();
+		program.compile(begin, end, mode);
+		if (mode == RPN_MODE_FLOAT)
+			status = runReal(program, result);
+		else if (mode == RPN_MODE_I64)
+			status = runWide(program, result);
 		else
-		{
-			operatorError();
-			return (ERROR);
-		}
-	}
-	if (!check_operator)
-	{
-		missingOperatorError();
-		return (ERROR);
+			status = runInt(program, result);
+		if (status == RPN_RANGE_ERROR && bignum)
+			status = runBig(program, result);
+		if (status != RPN_OK)
+			appendRpnError(result, status, program.errorOffset(), mode);
+		if (cache)
+			cache->insert(begin, end, tag, status, result.data(), result.size());
 	}
-	if (stack.size() > 1)
+
+	if (status != RPN_OK)
 	{
-		remainderError();
+		reportError(result);
 		return (ERROR);
 	}
 
 	std::cout << UNDERLINE "Result:" RESET
-			<< " " REVERSED " " << stack.top() 
+			<< " " REVERSED " " << result
 			<< " " RESET << std::endl;
 
 	return (OK);
@@ -60,105 +65,65 @@ int	RPN(const std::string& expression)
 
 
 // --- helper functions definition ---
-static bool	isValidValue(const std::string& token, int& value)
+static void	reportError(const std::string& message)
 {
-	if (token.empty())
-		return (false);
-
-	std::istringstream iss_digits(token);
-	if (!(iss_digits >> value))
-		return (false);
-
-	char check;
-	return (!(iss_digits >> check));
+	std::cerr << RED "Error:" RESET << " " << message << std::endl;
 }
 
-static int	handleOperator(const char oper, std::stack<int>& stack,
-							bool& check_operator)
+static RpnStatus	runInt(const RpnProgram& program, std::string& result)
 {
-	if (!isValidOperator(oper) || stack.size() < 2)
-	{
-		operatorError();
-		return (ERROR);
-	}
-
-	if (!check_operator)
-		check_operator = true;
-
-	int	value_2 = stack.top();
-	stack.pop();
-	int	value_1 = stack.top();
-	stack.pop();
-	if (oper == '/' && value_2 == 0)
-	{
-		divisionByZeroError();
-		return (ERROR);
-	}
+	static std::vector<int>	stack;
+	int						value = 0;
 
-	long long total = doOperation(value_1, value_2, oper);
-	if (total == ERROR_LL)
-	{
-		rangeError();
-		return (ERROR);
-	}
-
-	stack.push(static_cast<int>(total));
+	if (stack.size() <= program.maxDepth())
+		stack.resize(program.maxDepth() + 1);
 
-	return (OK);
-}
-
-static bool	isValidOperator(char oper)
-{
-	return (oper == '+' || oper == '-' || oper == '*' || oper == '/');
+	RpnStatus	status = program.run(&stack[0], value);
+	if (status == RPN_OK)
+		appendRpnInteger(result, value);
+	return (status);
 }
 
-static long long doOperation(int value_1, int value_2, char oper)
+static RpnStatus	runWide(const RpnProgram& program, std::string& result)
 {
-	long long result = 0;
-
-	if (oper == '+')
-		result = static_cast<long long>(value_1) + value_2;
-	else if (oper == '-')
-		result = static_cast<long long>(value_1) - value_2;
-	else if (oper == '*')
-		result = static_cast<long long>(value_1) * value_2;
-	else if (oper == '/')
-		result = static_cast<long long>(value_1) / value_2;
-	else
-		return (ERROR_LL);
+	static std::vector<long long>	stack;
+	long long						value = 0;
 
-	if (result > INT_MAX || result < INT_MIN)
-		return (ERROR_LL);
+	if (stack.size() <= program.maxDepth())
+		stack.resize(program.maxDepth() + 1);
 
-	return (result);
+	RpnStatus	status = program.run(&stack[0], value);
+	if (status == RPN_OK)
+		appendRpnInteger(result, value);
+	return (status);
 }
 
-static void rangeError()
+static RpnStatus	runReal(const RpnProgram& program, std::string& result)
 {
-	std::cerr << RED "Error:" RESET
-		<< " invalid operation and/or expression result outside int range." << std::endl;
-}
+	static std::vector<double>	stack;
+	double						value = 0;
 
-static void	operatorError()
-{
-	std::cerr << RED "Error:" RESET
-		<< " invalid character and/or too many operators." << std::endl;
-}
+	if (stack.size() <= program.maxDepth())
+		stack.resize(program.maxDepth() + 1);
 
-static void	remainderError()
-{
-	std::cerr << RED "Error:" RESET
-		<< " remainder at the end." << std::endl;
+	RpnStatus	status = program.run(&stack[0], value);
+	if (status == RPN_OK)
+		appendRpnReal(result, value);
+	return (status);
 }
 
-static void divisionByZeroError()
+// the limb buffers are recycled across calls through the pool
+static RpnStatus	runBig(const RpnProgram& program, std::string& result)
 {
-    std::cerr << RED "Error:" RESET
-		<< " division by zero." << std::endl;
-}
+	static LimbPool				pool;
+	static std::vector<BigInt>	stack;
+	static BigInt				value(pool);
 
-static void	missingOperatorError()
-{
-	std::cerr << RED "Error:" RESET
-		<< " expression has no operator." << std::endl;
+	if (stack.size() <= program.maxDepth())
+		stack.resize(program.maxDepth() + 1, BigInt(pool));
+
+	RpnStatus	status = program.runBig(&stack[0], value);
+	if (status == RPN_OK)
+		value.appendTo(result);
+	return (status);
 }
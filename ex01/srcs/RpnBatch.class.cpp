@@ -0,0 +1,307 @@
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#include "dictionary.hpp"
+#include "RpnBatch.class.hpp"
+#include "WorkerPool.class.hpp"
+
+// --- constructors / destructor ---
+RpnBatch::RpnBatch(int in_fd, int out_fd, size_t threads, RpnMode mode,
+		bool bignum, size_t cache_limit)
+	: _inFd(in_fd), _outFd(out_fd), _threads(threads > 0 ? threads : 1),
+	_mode(mode), _bignum(bignum), _cacheLimit(cache_limit),
+	_writeFailed(false), _lines(0), _errors(0), _cacheHits(0),
+	_cacheMisses(0), _cacheEvictions(0)
+{
+
+}
+
+RpnBatch::~RpnBatch()
+{
+
+}
+
+RpnBatch::Job::Job()
+	: data(NULL), len(0), mode(RPN_MODE_INT), bignum(false), bigResult(pool),
+	cache(NULL), lines(0), errors(0)
+{
+
+}
+
+RpnBatch::Job::~Job()
+{
+	delete cache;
+}
+
+
+
+
+
+// --- methods ---
+// Each round reads until the buffer is full, a read comes back short or
+// the input ends, cuts the buffer after its last newline (or at end of
+// input) into one newline-aligned slice per worker, evaluates the slices
+// and writes their outputs back in order.
+int	RpnBatch::run()
+{
+	WorkerPool			pool(_threads > 1 ? _threads : 0);
+	std::vector<char>	buf(_threads * BATCH_CHUNK);
+	std::vector<Job*>	jobs(_threads);
+	size_t				filled = 0;
+	bool				eof = false;
+	int					status = OK;
+
+	for (size_t i = 0; i < _threads; i++)
+	{
+		jobs[i] = new Job();
+		jobs[i]->mode = _mode;
+		jobs[i]->bignum = _bignum;
+		if (_cacheLimit > 0)
+			jobs[i]->cache = new RpnCache(_cacheLimit / _threads);
+	}
+
+	while (!eof && status == OK)
+	{
+		if (filled == buf.size())
+			buf.resize(buf.size() * 2);
+		while (filled < buf.size() && !eof)
+		{
+			ssize_t	got = read(_inFd, &buf[filled], buf.size() - filled);
+
+			if (got < 0 && errno == EINTR)
+				continue;
+			if (got < 0)
+			{
+				status = ERROR;
+				break;
+			}
+			if (got == 0)
+				eof = true;
+			filled += static_cast<size_t>(got);
+			// a short read means the writer has nothing more for now:
+			// answer the lines already here instead of waiting for a full
+			// buffer (a pipe fed interactively would otherwise stall)
+			if (got > 0 && filled < buf.size())
+				break;
+		}
+
+		size_t	cut = filled;
+		if (!eof)
+		{
+			while (cut > 0 && buf[cut - 1] != '\n')
+				cut--;
+			if (cut == 0)
+				continue;
+		}
+
+		size_t	start = 0;
+		for (size_t i = 0; i < _threads; i++)
+		{
+			size_t	stop = (i + 1 == _threads) ? cut : cut / _threads * (i + 1);
+
+			if (stop < start)
+				stop = start;
+			while (stop > 0 && stop < cut && buf[stop - 1] != '\n')
+				stop++;
+			jobs[i]->data = &buf[0] + start;
+			jobs[i]->len = stop - start;
+			jobs[i]->out.clear();
+			start = stop;
+		}
+
+		pool.run(processChunk, reinterpret_cast<void**>(&jobs[0]), _threads);
+
+		for (size_t i = 0; i < _threads && status == OK; i++)
+		{
+			if (!writeOut(jobs[i]->out))
+			{
+				_writeFailed = true;
+				status = ERROR;
+			}
+		}
+
+		if (cut < filled)
+			std::memmove(&buf[0], &buf[cut], filled - cut);
+		filled -= cut;
+	}
+
+	for (size_t i = 0; i < _threads; i++)
+	{
+		_lines += jobs[i]->lines;
+		_errors += jobs[i]->errors;
+		if (jobs[i]->cache)
+		{
+			_cacheHits += jobs[i]->cache->hits();
+			_cacheMisses += jobs[i]->cache->misses();
+			_cacheEvictions += jobs[i]->cache->evictions();
+		}
+		delete jobs[i];
+	}
+	return (status);
+}
+
+// after run() returned ERROR: true when the output, not the input, failed
+bool	RpnBatch::writeFailed() const
+{
+	return (_writeFailed);
+}
+
+size_t	RpnBatch::lines() const
+{
+	return (_lines);
+}
+
+size_t	RpnBatch::errors() const
+{
+	return (_errors);
+}
+
+size_t	RpnBatch::cacheHits() const
+{
+	return (_cacheHits);
+}
+
+size_t	RpnBatch::cacheMisses() const
+{
+	return (_cacheMisses);
+}
+
+size_t	RpnBatch::cacheEvictions() const
+{
+	return (_cacheEvictions);
+}
+
+void	RpnBatch::processChunk(void* arg)
+{
+	Job*		job = static_cast<Job*>(arg);
+	const char*	cur = job->data;
+	const char*	end = job->data + job->len;
+
+	while (cur < end)
+	{
+		const char*	eol = static_cast<const char*>(std::memchr(cur, '\n',
+				static_cast<size_t>(end - cur)));
+		const char*	line_end = eol ? eol : end;
+
+		evaluateLine(*job, cur, line_end);
+		cur = eol ? eol + 1 : end;
+	}
+}
+
+// A cached line appends its stored output line; any other is evaluated and
+// its output line, result or error, stored without the newline.
+void	RpnBatch::evaluateLine(Job& job, const char* begin, const char* end)
+{
+	RpnStatus			status = RPN_OK;
+	int					tag = job.mode * 2 + job.bignum;
+	const std::string*	cached = NULL;
+	size_t				mark = job.out.size();
+
+	if (job.cache)
+		cached = job.cache->find(begin, end, tag, status);
+	if (cached)
+	{
+		job.out += *cached;
+		job.out += '\n';
+	}
+	else
+	{
+		status = evaluate(job, begin, end);
+		if (status != RPN_OK)
+			appendRpnResult(job.out, status, 0, job.program.errorOffset(),
+				job.mode);
+		if (job.cache)
+			job.cache->insert(begin, end, tag, status, job.out.data() + mark,
+				job.out.size() - mark - 1);
+	}
+	job.errors += (status != RPN_OK);
+	job.lines++;
+}
+
+// each evaluate*() appends the result line when it succeeds
+RpnStatus	RpnBatch::evaluate(Job& job, const char* begin, const char* end)
+{
+	RpnStatus	status;
+
+	job.program.compile(begin, end, job.mode);
+	if (job.mode == RPN_MODE_FLOAT)
+		status = evaluateReal(job);
+	else if (job.mode == RPN_MODE_I64)
+		status = evaluateWide(job);
+	else
+		status = evaluateInt(job);
+	if (status == RPN_RANGE_ERROR && job.bignum)
+		status = evaluateBig(job);
+	return (status);
+}
+
+RpnStatus	RpnBatch::evaluateInt(Job& job)
+{
+	int	result = 0;
+
+	if (job.stack.size() <= job.program.maxDepth())
+		job.stack.resize(job.program.maxDepth() + 1);
+
+	RpnStatus	status = job.program.run(&job.stack[0], result);
+	if (status == RPN_OK)
+		appendRpnResult(job.out, status, result);
+	return (status);
+}
+
+RpnStatus	RpnBatch::evaluateWide(Job& job)
+{
+	long long	result = 0;
+
+	if (job.wideStack.size() <= job.program.maxDepth())
+		job.wideStack.resize(job.program.maxDepth() + 1);
+
+	RpnStatus	status = job.program.run(&job.wideStack[0], result);
+	if (status == RPN_OK)
+		appendRpnResult(job.out, status, result);
+	return (status);
+}
+
+RpnStatus	RpnBatch::evaluateReal(Job& job)
+{
+	double	result = 0;
+
+	if (job.realStack.size() <= job.program.maxDepth())
+		job.realStack.resize(job.program.maxDepth() + 1);
+
+	RpnStatus	status = job.program.run(&job.realStack[0], result);
+	if (status == RPN_OK)
+		appendRpnResult(job.out, status, result);
+	return (status);
+}
+
+RpnStatus	RpnBatch::evaluateBig(Job& job)
+{
+	if (job.bigStack.size() <= job.program.maxDepth())
+		job.bigStack.resize(job.program.maxDepth() + 1, BigInt(job.pool));
+
+	RpnStatus	status = job.program.runBig(&job.bigStack[0], job.bigResult);
+	if (status == RPN_OK)
+		appendRpnResult(job.out, job.bigResult);
+	return (status);
+}
+
+bool	RpnBatch::writeOut(const std::string& out)
+{
+	const char*	cur = out.data();
+	size_t		left = out.size();
+
+	while (left > 0)
+	{
+		ssize_t	written = write(_outFd, cur, left);
+
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return (false);
+		cur += written;
+		left -= static_cast<size_t>(written);
+	}
+	return (true);
+}
+
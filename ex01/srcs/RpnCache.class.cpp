@@ -0,0 +1,220 @@
+#include <cstring>
+
+#include "RpnCache.class.hpp"
+
+const size_t	RpnCache::NONE;
+
+// --- constructors / destructor ---
+RpnCache::RpnCache(size_t limit)
+	: _buckets(RPN_CACHE_BUCKETS, NONE), _free(NONE), _newest(NONE),
+	_oldest(NONE), _count(0), _bytes(0), _limit(limit), _hits(0), _misses(0),
+	_evictions(0)
+{
+
+}
+
+RpnCache::~RpnCache()
+{
+
+}
+
+
+
+
+
+// --- methods ---
+// the cached text of the expression, or NULL; it stays valid until the
+// next insert()
+const std::string*	RpnCache::find(const char* begin, const char* end,
+						int tag, RpnStatus& status)
+{
+	size_t	index = lookup(hashKey(begin, end, tag), begin, end, tag);
+
+	if (index == NONE)
+	{
+		_misses++;
+		return (NULL);
+	}
+	_hits++;
+	if (index != _newest)
+	{
+		unlink(index);
+		linkNewest(index);
+	}
+	status = _entries[index].status;
+	return (&_entries[index].result);
+}
+
+// An entry larger than the whole limit is not kept; otherwise the least
+// recently used ones are evicted until it fits.
+void	RpnCache::insert(const char* begin, const char* end, int tag,
+			RpnStatus status, const char* result, size_t len)
+{
+	size_t	size = static_cast<size_t>(end - begin);
+	size_t	needed = entryBytes(size, len);
+	size_t	index;
+
+	if (needed > _limit)
+		return ;
+	while (_bytes + needed > _limit)
+		evictOldest();
+	if (_count >= _buckets.size())
+		grow();
+
+	if (_free != NONE)
+	{
+		index = _free;
+		_free = _entries[index].chain;
+	}
+	else
+	{
+		index = _entries.size();
+		_entries.push_back(Entry());
+	}
+
+	Entry&	entry = _entries[index];
+	size_t	bucket;
+
+	entry.hash = hashKey(begin, end, tag);
+	entry.key.assign(begin, size);
+	entry.result.assign(result, len);
+	entry.status = status;
+	entry.tag = tag;
+	bucket = static_cast<size_t>(entry.hash) & (_buckets.size() - 1);
+	entry.chain = _buckets[bucket];
+	_buckets[bucket] = index;
+	linkNewest(index);
+	_count++;
+	_bytes += needed;
+}
+
+size_t	RpnCache::hits() const
+{
+	return (_hits);
+}
+
+size_t	RpnCache::misses() const
+{
+	return (_misses);
+}
+
+size_t	RpnCache::evictions() const
+{
+	return (_evictions);
+}
+
+size_t	RpnCache::entries() const
+{
+	return (_count);
+}
+
+size_t	RpnCache::bytes() const
+{
+	return (_bytes);
+}
+
+size_t	RpnCache::limit() const
+{
+	return (_limit);
+}
+
+// FNV-1a over the tag, then the text
+uint64_t	RpnCache::hashKey(const char* begin, const char* end, int tag)
+{
+	uint64_t	hash = 14695981039346656037ULL;
+
+	hash ^= static_cast<unsigned int>(tag);
+	hash *= 1099511628211ULL;
+	for (; begin < end; begin++)
+	{
+		hash ^= static_cast<unsigned char>(*begin);
+		hash *= 1099511628211ULL;
+	}
+	return (hash);
+}
+
+// what an entry counts against the limit: itself, its share of the
+// buckets and its two texts
+size_t	RpnCache::entryBytes(size_t key, size_t result)
+{
+	return (sizeof(Entry) + sizeof(size_t) + key + result);
+}
+
+size_t	RpnCache::lookup(uint64_t hash, const char* begin, const char* end,
+			int tag) const
+{
+	size_t	size = static_cast<size_t>(end - begin);
+	size_t	index = _buckets[static_cast<size_t>(hash) & (_buckets.size() - 1)];
+
+	for (; index != NONE; index = _entries[index].chain)
+	{
+		const Entry&	entry = _entries[index];
+
+		if (entry.hash == hash && entry.tag == tag && entry.key.size() == size
+			&& !std::memcmp(entry.key.data(), begin, size))
+			return (index);
+	}
+	return (NONE);
+}
+
+// takes the entry out of the recency list
+void	RpnCache::unlink(size_t index)
+{
+	Entry&	entry = _entries[index];
+
+	if (entry.newer != NONE)
+		_entries[entry.newer].older = entry.older;
+	else
+		_newest = entry.older;
+	if (entry.older != NONE)
+		_entries[entry.older].newer = entry.newer;
+	else
+		_oldest = entry.newer;
+}
+
+void	RpnCache::linkNewest(size_t index)
+{
+	Entry&	entry = _entries[index];
+
+	entry.newer = NONE;
+	entry.older = _newest;
+	if (_newest != NONE)
+		_entries[_newest].newer = index;
+	else
+		_oldest = index;
+	_newest = index;
+}
+
+// unlinks the least recently used entry from its bucket and the recency
+// list and moves it to the free list, keeping its buffers
+void	RpnCache::evictOldest()
+{
+	size_t	index = _oldest;
+	Entry&	entry = _entries[index];
+	size_t*	link = &_buckets[static_cast<size_t>(entry.hash)
+		& (_buckets.size() - 1)];
+
+	while (*link != index)
+		link = &_entries[*link].chain;
+	*link = entry.chain;
+	unlink(index);
+	entry.chain = _free;
+	_free = index;
+	_count--;
+	_bytes -= entryBytes(entry.key.size(), entry.result.size());
+	_evictions++;
+}
+
+// twice the buckets, every entry chained again from the recency list
+void	RpnCache::grow()
+{
+	_buckets.assign(_buckets.size() * 2, NONE);
+	for (size_t index = _newest; index != NONE; index = _entries[index].older)
+	{
+		size_t	bucket = static_cast<size_t>(_entries[index].hash)
+			& (_buckets.size() - 1);
+
+		_entries[index].chain = _buckets[bucket];
+		_buckets[bucket] = index;
+	}
+}
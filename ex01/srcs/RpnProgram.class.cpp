@@ -0,0 +1,1331 @@
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "RpnProgram.class.hpp"
+
+// --- helper functions declaration ---
+static bool			isBlank(char c);
+static const RpnOperator*	findOperator(const char* begin, const char* end,
+								int& count);
+static bool			isVariableName(const char* begin, const char* end);
+static RpnStatus	powInteger(long long base, long long exponent,
+						long long low, long long high, long long& result);
+static RpnStatus	powBig(BigInt& base, const BigInt& exponent);
+static bool			isFinite(double value);
+static size_t		foldSlot(RpnOpcode opcode, int lhs, int rhs);
+static void	blockAdd(int* __restrict__ a, const int* __restrict__ b,
+				int* __restrict__ lanes);
+static void	blockSub(int* __restrict__ a, const int* __restrict__ b,
+				int* __restrict__ lanes);
+static void	blockMul(int* __restrict__ a, const int* __restrict__ b,
+				int* __restrict__ lanes);
+static void	blockDiv(int* __restrict__ a, const int* __restrict__ b,
+				int* __restrict__ lanes);
+static void	blockMod(int* __restrict__ a, const int* __restrict__ b,
+				int* __restrict__ lanes);
+static void	blockPow(int* __restrict__ a, const int* __restrict__ b,
+				int* __restrict__ lanes);
+static void	blockMin(int* __restrict__ a, const int* __restrict__ b);
+static void	blockMax(int* __restrict__ a, const int* __restrict__ b);
+static void	blockNeg(int* __restrict__ a, int* __restrict__ lanes);
+
+// --- operator registry ---
+// To add an operator: give it an opcode, a line here, and a case in every
+// run loop. Lookup happens at compile time only.
+static const RpnOperator	g_operators[] = {
+	{"+", OP_ADD, 2, 1},
+	{"-", OP_SUB, 2, 1},
+	{"*", OP_MUL, 2, 1},
+	{"/", OP_DIV, 2, 1},
+	{"%", OP_MOD, 2, 1},
+	{"pow", OP_POW, 2, 1},
+	{"min", OP_MIN, 2, 1},
+	{"max", OP_MAX, 2, 1},
+	{"neg", OP_NEG, 1, 1},
+	{"dup", OP_DUP, 1, 2},
+	{"swap", OP_SWAP, 2, 2},
+	{"drop", OP_DROP, 1, 0},
+	{"sum", OP_SUM, 0, 1},
+	{NULL, OP_FAIL, 0, 0}
+};
+
+// --- constructors / destructor ---
+RpnProgram::RpnProgram()
+	: _maxDepth(0), _errorOffset(RPN_NO_OFFSET)
+{
+	for (size_t i = 0; i < RPN_FOLD_MEMO; i++)
+		_folds[i].opcode = OP_FAIL;
+}
+
+RpnProgram::~RpnProgram()
+{
+
+}
+
+
+
+
+
+// --- methods ---
+void	RpnProgram::compile(const std::string& expression, RpnMode mode)
+{
+	compile(expression.data(), expression.data() + expression.size(), mode);
+}
+
+void	RpnProgram::compile(const char* begin, const char* end, RpnMode mode)
+{
+	compileTokens(begin, end, false, mode);
+}
+
+void	RpnProgram::compileTemplate(const char* begin, const char* end)
+{
+	compileTokens(begin, end, true, RPN_MODE_INT);
+}
+
+// Tokens are split on blanks and scanned in place; a token is a value when
+// it reads as a number of the mode with nothing left over, else it must be
+// a registered operator with enough operands on the stack (or, in a
+// template, a variable name). A token that stops compilation has its byte
+// offset recorded for errorOffset(); so has the last operator to empty the
+// stack, when nothing is left on it at the end.
+void	RpnProgram::compileTokens(const char* begin, const char* end,
+			bool variables, RpnMode mode)
+{
+	size_t		depth = 0;
+	size_t		emptied = RPN_NO_OFFSET;
+	bool		has_operator = false;
+	bool		fold = (mode != RPN_MODE_FLOAT);
+	const char*	cur = begin;
+
+	_code.clear();
+	_variables.clear();
+	_integers.clear();
+	_reals.clear();
+	_maxDepth = 0;
+	_errorOffset = RPN_NO_OFFSET;
+	for (;;)
+	{
+		const char*			token;
+		const RpnOperator*	op;
+		int					count;
+
+		while (cur < end && isBlank(*cur))
+			cur++;
+		if (cur == end)
+			break;
+		token = cur;
+		while (cur < end && !isBlank(*cur))
+			cur++;
+
+		if (compileValue(token, cur, mode))
+			depth++;
+		else if ((op = findOperator(token, cur, count)) != NULL)
+		{
+			if (depth < static_cast<size_t>(count))
+			{
+				emit(OP_FAIL, RPN_OPERATOR_ERROR);
+				_errorOffset = static_cast<size_t>(token - begin);
+				return ;
+			}
+			if (!fold || !foldOperator(op->opcode, op->pops ? 0 : count,
+					count, op->pushes))
+				emit(op->opcode, op->pops ? 0 : count);
+			depth = depth - count + op->pushes;
+			if (depth == 0)
+				emptied = static_cast<size_t>(token - begin);
+			has_operator = true;
+		}
+		else if (variables && isVariableName(token, cur))
+		{
+			emit(OP_LOAD, variableIndex(token, cur));
+			depth++;
+		}
+		else
+		{
+			emit(OP_FAIL, RPN_INVALID_TOKEN);
+			_errorOffset = static_cast<size_t>(token - begin);
+			return ;
+		}
+		if (depth > _maxDepth)
+			_maxDepth = depth;
+	}
+
+	if (!has_operator)
+		emit(OP_FAIL, RPN_MISSING_OPERATOR);
+	else if (depth > 1)
+		emit(OP_FAIL, RPN_REMAINDER);
+	else if (depth == 0)
+	{
+		emit(OP_FAIL, RPN_OPERATOR_ERROR);
+		_errorOffset = emptied;
+	}
+	else
+		emit(OP_RETURN, 0);
+}
+
+// int literals stay inline in OP_PUSH in every mode; wider ones go to the
+// mode's constant pool
+bool	RpnProgram::compileValue(const char* begin, const char* end,
+			RpnMode mode)
+{
+	int			value;
+	long long	wide;
+	double		real;
+
+	if (parseRpnValue(begin, end, value))
+		emit(OP_PUSH, value);
+	else if (mode == RPN_MODE_I64 && parseRpnWide(begin, end, wide))
+	{
+		emit(OP_PUSH_WIDE, static_cast<int>(_integers.size()));
+		_integers.push_back(wide);
+	}
+	else if (mode == RPN_MODE_FLOAT && parseRpnReal(begin, end, real))
+	{
+		emit(OP_PUSH_REAL, static_cast<int>(_reals.size()));
+		_reals.push_back(real);
+	}
+	else
+		return (false);
+	return (true);
+}
+
+// The operands are constants when the last pops instructions all push
+// one. They are run through runExtended() on a scratch stack, ended by an
+// OP_FAIL that reports success, and, when the operator succeeds, their
+// pushes are replaced by pushes of its results. Int results are the same
+// in RPN_MODE_I64, where an int operation that fails is left to run().
+bool	RpnProgram::foldOperator(RpnOpcode opcode, int operand, int pops,
+			int pushes)
+{
+	RpnInstruction	code[2] = {{opcode, operand}, {OP_FAIL, RPN_OK}};
+	size_t			first = _code.size() - pops;
+	RpnFold*		memo = NULL;
+	int				unused;
+
+	for (size_t i = first; i < _code.size(); i++)
+	{
+		if (_code[i].opcode != OP_PUSH)
+			return (false);
+	}
+	if (_foldStack.size() < static_cast<size_t>(pops) + 1)
+		_foldStack.resize(pops + 1);
+	for (int i = 0; i < pops; i++)
+		_foldStack[i] = _code[first + i].operand;
+
+	if (pops == 2 && pushes == 1)
+	{
+		memo = &_folds[foldSlot(opcode, _foldStack[0], _foldStack[1])];
+		if (memo->opcode == opcode && memo->lhs == _foldStack[0]
+			&& memo->rhs == _foldStack[1])
+		{
+			_code.resize(first);
+			emit(OP_PUSH, memo->result);
+			return (true);
+		}
+	}
+	if (runExtended(code, &_foldStack[0] + pops, unused, NULL) != RPN_OK)
+		return (false);
+	if (memo)
+	{
+		memo->opcode = opcode;
+		memo->lhs = _code[first].operand;
+		memo->rhs = _code[first + 1].operand;
+		memo->result = _foldStack[0];
+	}
+	_code.resize(first);
+	for (int i = 0; i < pushes; i++)
+		emit(OP_PUSH, _foldStack[i]);
+	return (true);
+}
+
+// Every result is computed in long long and must fit an int. Programs made
+// of the original four operators never leave this loop, which has no call
+// and keeps everything in scratch registers; any other opcode hands the
+// rest of the program over to runExtended() as a tail call.
+RpnStatus	RpnProgram::run(int* stack, int& result, const int* values) const
+{
+	const RpnInstruction*	ip = &_code[0];
+	int*					top = stack;
+	long long				total;
+
+	for (;; ip++)
+	{
+		switch (ip->opcode)
+		{
+			case OP_PUSH:
+				*top++ = ip->operand;
+				continue;
+
+			case OP_LOAD:
+				*top++ = values[ip->operand];
+				continue;
+
+			case OP_ADD:
+				total = static_cast<long long>(top[-2]) + top[-1];
+				break;
+
+			case OP_SUB:
+				total = static_cast<long long>(top[-2]) - top[-1];
+				break;
+
+			case OP_MUL:
+				total = static_cast<long long>(top[-2]) * top[-1];
+				break;
+
+			case OP_DIV:
+				if (top[-1] == 0)
+					return (RPN_DIVISION_BY_ZERO);
+				total = static_cast<long long>(top[-2]) / top[-1];
+				break;
+
+			case OP_RETURN:
+				result = top[-1];
+				return (RPN_OK);
+
+			case OP_FAIL:
+				return (static_cast<RpnStatus>(ip->operand));
+
+			default:
+				return (runExtended(ip, top, result, values));
+		}
+		if (total > INT_MAX || total < INT_MIN)
+			return (RPN_RANGE_ERROR);
+		top--;
+		top[-1] = static_cast<int>(total);
+	}
+}
+
+// run() from ip on, with every operator. The binary arithmetic operators
+// share the range check and pop at the bottom of the loop; the others
+// adjust the stack themselves and continue.
+RpnStatus	RpnProgram::runExtended(const RpnInstruction* ip, int* top,
+				int& result, const int* values) const
+{
+	long long	total;
+	long long	power;
+	RpnStatus	status;
+
+	for (;; ip++)
+	{
+		switch (ip->opcode)
+		{
+			case OP_PUSH:
+				*top++ = ip->operand;
+				continue;
+
+			case OP_LOAD:
+				*top++ = values[ip->operand];
+				continue;
+
+			case OP_ADD:
+				total = static_cast<long long>(top[-2]) + top[-1];
+				break;
+
+			case OP_SUB:
+				total = static_cast<long long>(top[-2]) - top[-1];
+				break;
+
+			case OP_MUL:
+				total = static_cast<long long>(top[-2]) * top[-1];
+				break;
+
+			case OP_DIV:
+				if (top[-1] == 0)
+					return (RPN_DIVISION_BY_ZERO);
+				total = static_cast<long long>(top[-2]) / top[-1];
+				break;
+
+			case OP_MOD:
+				if (top[-1] == 0)
+					return (RPN_DIVISION_BY_ZERO);
+				total = static_cast<long long>(top[-2]) % top[-1];
+				break;
+
+			case OP_POW:
+				status = powInteger(top[-2], top[-1], INT_MIN, INT_MAX, power);
+				if (status != RPN_OK)
+					return (status);
+				total = power;
+				break;
+
+			case OP_MIN:
+				total = std::min(top[-2], top[-1]);
+				break;
+
+			case OP_MAX:
+				total = std::max(top[-2], top[-1]);
+				break;
+
+			case OP_NEG:
+				if (top[-1] == INT_MIN)
+					return (RPN_RANGE_ERROR);
+				top[-1] = -top[-1];
+				continue;
+
+			case OP_DUP:
+				*top = top[-1];
+				top++;
+				continue;
+
+			case OP_SWAP:
+				std::swap(top[-2], top[-1]);
+				continue;
+
+			case OP_DROP:
+				top--;
+				continue;
+
+			case OP_SUM:
+				top -= ip->operand;
+				total = top[0];
+				for (int i = 1; i < ip->operand; i++)
+				{
+					total += top[i];
+					if (total > INT_MAX || total < INT_MIN)
+						return (RPN_RANGE_ERROR);
+				}
+				*top++ = static_cast<int>(total);
+				continue;
+
+			case OP_RETURN:
+				result = top[-1];
+				return (RPN_OK);
+
+			default:
+				return (static_cast<RpnStatus>(ip->operand));
+		}
+		if (total > INT_MAX || total < INT_MIN)
+			return (RPN_RANGE_ERROR);
+		top--;
+		top[-1] = static_cast<int>(total);
+	}
+}
+
+// the same in 64 bits, where overflow is caught by the checked builtins
+RpnStatus	RpnProgram::run(long long* stack, long long& result) const
+{
+	const RpnInstruction*	ip = &_code[0];
+	long long*				top = stack;
+	long long				total;
+	long long				power;
+	RpnStatus				status;
+
+	for (;; ip++)
+	{
+		switch (ip->opcode)
+		{
+			case OP_PUSH:
+				*top++ = ip->operand;
+				continue;
+
+			case OP_PUSH_WIDE:
+				*top++ = _integers[ip->operand];
+				continue;
+
+			case OP_ADD:
+				if (__builtin_add_overflow(top[-2], top[-1], &total))
+					return (RPN_RANGE_ERROR);
+				break;
+
+			case OP_SUB:
+				if (__builtin_sub_overflow(top[-2], top[-1], &total))
+					return (RPN_RANGE_ERROR);
+				break;
+
+			case OP_MUL:
+				if (__builtin_mul_overflow(top[-2], top[-1], &total))
+					return (RPN_RANGE_ERROR);
+				break;
+
+			case OP_DIV:
+				if (top[-1] == 0)
+					return (RPN_DIVISION_BY_ZERO);
+				if (top[-2] == LLONG_MIN && top[-1] == -1)
+					return (RPN_RANGE_ERROR);
+				total = top[-2] / top[-1];
+				break;
+
+			case OP_MOD:
+				if (top[-1] == 0)
+					return (RPN_DIVISION_BY_ZERO);
+				total = (top[-1] == -1) ? 0 : top[-2] % top[-1];
+				break;
+
+			case OP_POW:
+				status = powInteger(top[-2], top[-1], LLONG_MIN, LLONG_MAX, power);
+				if (status != RPN_OK)
+					return (status);
+				total = power;
+				break;
+
+			case OP_MIN:
+				total = std::min(top[-2], top[-1]);
+				break;
+
+			case OP_MAX:
+				total = std::max(top[-2], top[-1]);
+				break;
+
+			case OP_NEG:
+				if (top[-1] == LLONG_MIN)
+					return (RPN_RANGE_ERROR);
+				top[-1] = -top[-1];
+				continue;
+
+			case OP_DUP:
+				*top = top[-1];
+				top++;
+				continue;
+
+			case OP_SWAP:
+				std::swap(top[-2], top[-1]);
+				continue;
+
+			case OP_DROP:
+				top--;
+				continue;
+
+			case OP_SUM:
+				top -= ip->operand;
+				for (int i = 1; i < ip->operand; i++)
+				{
+					if (__builtin_add_overflow(top[0], top[i], &top[0]))
+						return (RPN_RANGE_ERROR);
+				}
+				top++;
+				continue;
+
+			case OP_RETURN:
+				result = top[-1];
+				return (RPN_OK);
+
+			default:
+				return (static_cast<RpnStatus>(ip->operand));
+		}
+		top--;
+		top[-1] = total;
+	}
+}
+
+// floating point: a zero divisor is still an error, and any result that
+// is not finite is out of range
+RpnStatus	RpnProgram::run(double* stack, double& result) const
+{
+	const RpnInstruction*	ip = &_code[0];
+	double*					top = stack;
+	double					total;
+
+	for (;; ip++)
+	{
+		switch (ip->opcode)
+		{
+			case OP_PUSH:
+				*top++ = ip->operand;
+				continue;
+
+			case OP_PUSH_REAL:
+				*top++ = _reals[ip->operand];
+				continue;
+
+			case OP_ADD:
+				total = top[-2] + top[-1];
+				break;
+
+			case OP_SUB:
+				total = top[-2] - top[-1];
+				break;
+
+			case OP_MUL:
+				total = top[-2] * top[-1];
+				break;
+
+			case OP_DIV:
+				if (top[-1] == 0)
+					return (RPN_DIVISION_BY_ZERO);
+				total = top[-2] / top[-1];
+				break;
+
+			case OP_MOD:
+				if (top[-1] == 0)
+					return (RPN_DIVISION_BY_ZERO);
+				total = std::fmod(top[-2], top[-1]);
+				break;
+
+			case OP_POW:
+				total = std::pow(top[-2], top[-1]);
+				break;
+
+			case OP_MIN:
+				total = std::min(top[-2], top[-1]);
+				break;
+
+			case OP_MAX:
+				total = std::max(top[-2], top[-1]);
+				break;
+
+			case OP_NEG:
+				top[-1] = -top[-1];
+				continue;
+
+			case OP_DUP:
+				*top = top[-1];
+				top++;
+				continue;
+
+			case OP_SWAP:
+				std::swap(top[-2], top[-1]);
+				continue;
+
+			case OP_DROP:
+				top--;
+				continue;
+
+			case OP_SUM:
+				top -= ip->operand;
+				for (int i = 1; i < ip->operand; i++)
+				{
+					top[0] += top[i];
+					if (!isFinite(top[0]))
+						return (RPN_RANGE_ERROR);
+				}
+				top++;
+				continue;
+
+			case OP_RETURN:
+				result = top[-1];
+				return (RPN_OK);
+
+			default:
+				return (static_cast<RpnStatus>(ip->operand));
+		}
+		if (!isFinite(total))
+			return (RPN_RANGE_ERROR);
+		top--;
+		top[-1] = total;
+	}
+}
+
+// stack holds at least maxDepth() BigInts of one pool
+RpnStatus	RpnProgram::runBig(BigInt* stack, BigInt& result,
+				const int* values) const
+{
+	const RpnInstruction*	ip = &_code[0];
+	BigInt*					top = stack;
+	RpnStatus				status;
+
+	for (;; ip++)
+	{
+		switch (ip->opcode)
+		{
+			case OP_PUSH:
+				(top++)->assign(ip->operand);
+				continue;
+
+			case OP_PUSH_WIDE:
+				(top++)->assign(_integers[ip->operand]);
+				continue;
+
+			case OP_LOAD:
+				(top++)->assign(values[ip->operand]);
+				continue;
+
+			case OP_ADD:
+				BigInt::add(top[-2], top[-1], top[-2]);
+				break;
+
+			case OP_SUB:
+				BigInt::sub(top[-2], top[-1], top[-2]);
+				break;
+
+			case OP_MUL:
+				BigInt::mul(top[-2], top[-1], top[-2]);
+				break;
+
+			case OP_DIV:
+				if (!BigInt::div(top[-2], top[-1], top[-2]))
+					return (RPN_DIVISION_BY_ZERO);
+				break;
+
+			case OP_MOD:
+				if (!BigInt::mod(top[-2], top[-1], top[-2]))
+					return (RPN_DIVISION_BY_ZERO);
+				break;
+
+			case OP_POW:
+				status = powBig(top[-2], top[-1]);
+				if (status != RPN_OK)
+					return (status);
+				break;
+
+			case OP_MIN:
+				if (BigInt::compare(top[-1], top[-2]) < 0)
+					top[-2].swap(top[-1]);
+				break;
+
+			case OP_MAX:
+				if (BigInt::compare(top[-1], top[-2]) > 0)
+					top[-2].swap(top[-1]);
+				break;
+
+			case OP_NEG:
+				top[-1].negate();
+				continue;
+
+			case OP_DUP:
+				*top = top[-1];
+				top++;
+				continue;
+
+			case OP_SWAP:
+				top[-2].swap(top[-1]);
+				continue;
+
+			case OP_DROP:
+				top--;
+				continue;
+
+			case OP_SUM:
+				top -= ip->operand;
+				for (int i = 1; i < ip->operand; i++)
+					BigInt::add(top[0], top[i], top[0]);
+				top++;
+				continue;
+
+			case OP_RETURN:
+				result = top[-1];
+				return (RPN_OK);
+
+			default:
+				return (static_cast<RpnStatus>(ip->operand));
+		}
+		top--;
+	}
+}
+
+// Row i of the result reads row i of every column; status[i] is RPN_OK
+// when results[i] holds a value, else the error a scalar run would report.
+void	RpnProgram::runColumns(const int* const* columns, size_t rows,
+			int* results, unsigned char* status, int* workspace) const
+{
+	for (size_t first = 0; first < rows; first += RPN_BLOCK)
+		runBlock(columns, first, std::min(rows - first,
+			static_cast<size_t>(RPN_BLOCK)), results, status, workspace);
+}
+
+size_t	RpnProgram::maxDepth() const
+{
+	return (_maxDepth);
+}
+
+// one block of status lanes, then one block per stack slot
+size_t	RpnProgram::workspaceSize() const
+{
+	return ((_maxDepth + 1) * RPN_BLOCK);
+}
+
+size_t	RpnProgram::size() const
+{
+	return (_code.size());
+}
+
+// byte offset in the source of the token compilation stopped at, or
+// RPN_NO_OFFSET when it did not stop on a token
+size_t	RpnProgram::errorOffset() const
+{
+	return (_errorOffset);
+}
+
+const std::vector<std::string>&	RpnProgram::variables() const
+{
+	return (_variables);
+}
+
+void	RpnProgram::emit(RpnOpcode opcode, int operand)
+{
+	RpnInstruction	instruction;
+
+	instruction.opcode = opcode;
+	instruction.operand = operand;
+	_code.push_back(instruction);
+}
+
+int	RpnProgram::variableIndex(const char* begin, const char* end)
+{
+	size_t	len = static_cast<size_t>(end - begin);
+
+	for (size_t i = 0; i < _variables.size(); i++)
+	{
+		if (_variables[i].size() == len
+			&& !std::memcmp(_variables[i].data(), begin, len))
+			return (static_cast<int>(i));
+	}
+	_variables.push_back(std::string(begin, end));
+	return (static_cast<int>(_variables.size() - 1));
+}
+
+// Every opcode runs over all RPN_BLOCK lanes, so the loops have a fixed
+// trip count and vectorize; lanes past count are loaded as zeros and never
+// written back. A lane keeps its first error, the values computed after it
+// are ignored.
+void	RpnProgram::runBlock(const int* const* columns, size_t first,
+			size_t count, int* results, unsigned char* status,
+			int* workspace) const
+{
+	int*					lanes = workspace;
+	int*					top = workspace + RPN_BLOCK;
+	const RpnInstruction*	ip = &_code[0];
+
+	std::fill(lanes, lanes + RPN_BLOCK, static_cast<int>(RPN_OK));
+	for (;; ip++)
+	{
+		switch (ip->opcode)
+		{
+			case OP_PUSH:
+				std::fill(top, top + RPN_BLOCK, ip->operand);
+				top += RPN_BLOCK;
+				break;
+
+			case OP_LOAD:
+				std::memcpy(top, columns[ip->operand] + first, count * sizeof(int));
+				std::fill(top + count, top + RPN_BLOCK, 0);
+				top += RPN_BLOCK;
+				break;
+
+			case OP_ADD:
+				top -= RPN_BLOCK;
+				blockAdd(top - RPN_BLOCK, top, lanes);
+				break;
+
+			case OP_SUB:
+				top -= RPN_BLOCK;
+				blockSub(top - RPN_BLOCK, top, lanes);
+				break;
+
+			case OP_MUL:
+				top -= RPN_BLOCK;
+				blockMul(top - RPN_BLOCK, top, lanes);
+				break;
+
+			case OP_DIV:
+				top -= RPN_BLOCK;
+				blockDiv(top - RPN_BLOCK, top, lanes);
+				break;
+
+			case OP_MOD:
+				top -= RPN_BLOCK;
+				blockMod(top - RPN_BLOCK, top, lanes);
+				break;
+
+			case OP_POW:
+				top -= RPN_BLOCK;
+				blockPow(top - RPN_BLOCK, top, lanes);
+				break;
+
+			case OP_MIN:
+				top -= RPN_BLOCK;
+				blockMin(top - RPN_BLOCK, top);
+				break;
+
+			case OP_MAX:
+				top -= RPN_BLOCK;
+				blockMax(top - RPN_BLOCK, top);
+				break;
+
+			case OP_NEG:
+				blockNeg(top - RPN_BLOCK, lanes);
+				break;
+
+			case OP_DUP:
+				std::memcpy(top, top - RPN_BLOCK, RPN_BLOCK * sizeof(int));
+				top += RPN_BLOCK;
+				break;
+
+			case OP_SWAP:
+				std::swap_ranges(top - 2 * RPN_BLOCK, top - RPN_BLOCK,
+					top - RPN_BLOCK);
+				break;
+
+			case OP_DROP:
+				top -= RPN_BLOCK;
+				break;
+
+			case OP_SUM:
+				top -= ip->operand * RPN_BLOCK;
+				for (int i = 1; i < ip->operand; i++)
+					blockAdd(top, top + i * RPN_BLOCK, lanes);
+				top += RPN_BLOCK;
+				break;
+
+			case OP_RETURN:
+				for (size_t j = 0; j < count; j++)
+				{
+					status[first + j] = static_cast<unsigned char>(lanes[j]);
+					results[first + j] = lanes[j] ? 0 : top[j - RPN_BLOCK];
+				}
+				return ;
+
+			default:
+				for (size_t j = 0; j < count; j++)
+				{
+					status[first + j] = static_cast<unsigned char>(lanes[j]
+						? lanes[j] : ip->operand);
+					results[first + j] = 0;
+				}
+				return ;
+		}
+	}
+}
+
+// the table, ended by an entry with a NULL token
+const RpnOperator*	rpnOperators()
+{
+	return (g_operators);
+}
+
+// Same grammar as reading the token with operator>> into an int and
+// finding nothing after it: an optional sign, then digits, in int range.
+// One pass: the magnitude is built in unsigned arithmetic and rejected on
+// the digit that takes it past the limit of its sign.
+bool	parseRpnValue(const char* begin, const char* end, int& value)
+{
+	bool			negative = false;
+	unsigned int	magnitude = 0;
+	unsigned int	limit = static_cast<unsigned int>(INT_MAX);
+
+	if (begin < end && (*begin == '+' || *begin == '-'))
+		negative = (*begin++ == '-');
+	if (begin == end)
+		return (false);
+	if (negative)
+		limit++;
+	for (; begin < end; begin++)
+	{
+		unsigned int	digit = static_cast<unsigned char>(*begin) - '0';
+
+		if (digit > 9 || magnitude > (limit - digit) / 10)
+			return (false);
+		magnitude = magnitude * 10 + digit;
+	}
+
+	value = negative ? static_cast<int>(0 - magnitude)
+		: static_cast<int>(magnitude);
+	return (true);
+}
+
+// the same grammar in long long range
+bool	parseRpnWide(const char* begin, const char* end, long long& value)
+{
+	bool				negative = false;
+	unsigned long long	magnitude = 0;
+	unsigned long long	limit = static_cast<unsigned long long>(LLONG_MAX);
+
+	if (begin < end && (*begin == '+' || *begin == '-'))
+		negative = (*begin++ == '-');
+	if (begin == end)
+		return (false);
+	if (negative)
+		limit++;
+	for (; begin < end; begin++)
+	{
+		unsigned int	digit = static_cast<unsigned char>(*begin) - '0';
+
+		if (digit > 9 || magnitude > (limit - digit) / 10)
+			return (false);
+		magnitude = magnitude * 10 + digit;
+	}
+
+	value = negative ? static_cast<long long>(0 - magnitude)
+		: static_cast<long long>(magnitude);
+	return (true);
+}
+
+// Decimal only: digits with an optional point, sign and exponent, finite;
+// no inf, nan or hexadecimal. strtod() needs a terminated copy, made on
+// the stack unless the token is longer than any double needs.
+bool	parseRpnReal(const char* begin, const char* end, double& value)
+{
+	size_t		len = static_cast<size_t>(end - begin);
+	bool		digit = false;
+	char		buffer[64];
+	std::string	longer;
+	const char*	text = buffer;
+	char*		stop;
+
+	for (const char* cur = begin; cur < end; cur++)
+	{
+		if (std::isdigit(static_cast<unsigned char>(*cur)))
+			digit = true;
+		else if (*cur == '\0' || !std::strchr(".eE+-", *cur))
+			return (false);
+	}
+	if (!digit)
+		return (false);
+	if (len < sizeof(buffer))
+	{
+		std::memcpy(buffer, begin, len);
+		buffer[len] = '\0';
+	}
+	else
+	{
+		longer.assign(begin, end);
+		text = longer.c_str();
+	}
+	value = std::strtod(text, &stop);
+	return (stop == text + len && isFinite(value));
+}
+
+// without the final period, so a location can follow; the range is the
+// one of the mode's number type
+const char*	rpnErrorMessage(RpnStatus status, RpnMode mode)
+{
+	if (status == RPN_RANGE_ERROR && mode == RPN_MODE_I64)
+		return ("invalid operation and/or expression result outside int64 range");
+	if (status == RPN_RANGE_ERROR && mode == RPN_MODE_FLOAT)
+		return ("invalid operation and/or expression result outside double range");
+	if (status == RPN_RANGE_ERROR)
+		return ("invalid operation and/or expression result outside int range");
+	if (status == RPN_DIVISION_BY_ZERO)
+		return ("division by zero");
+	if (status == RPN_REMAINDER)
+		return ("remainder at the end");
+	if (status == RPN_MISSING_OPERATOR)
+		return ("expression has no operator");
+	if (status == RPN_INVALID_TOKEN)
+		return ("invalid token");
+	return ("too many operators");
+}
+
+// The message of an error, then where its token starts when it has one:
+// only compile-time errors stop on a token, so the offset of an
+// expression that failed earlier at run time is not shown.
+void	appendRpnError(std::string& out, RpnStatus status, size_t offset,
+			RpnMode mode)
+{
+	out += rpnErrorMessage(status, mode);
+	if (offset != RPN_NO_OFFSET
+		&& (status == RPN_INVALID_TOKEN || status == RPN_OPERATOR_ERROR))
+	{
+		out += " at byte ";
+		appendRpnInteger(out, static_cast<long long>(offset));
+	}
+	out += '.';
+}
+
+void	appendRpnInteger(std::string& out, long long value)
+{
+	char				digits[24];
+	size_t				len = 0;
+	unsigned long long	magnitude = static_cast<unsigned long long>(value);
+
+	if (value < 0)
+	{
+		out += '-';
+		magnitude = 0 - magnitude;
+	}
+	do
+	{
+		digits[sizeof(digits) - ++len] = static_cast<char>('0' + magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude > 0);
+	out.append(digits + sizeof(digits) - len, len);
+}
+
+// as many significant digits as a double always keeps; -0 prints as 0
+void	appendRpnReal(std::string& out, double value)
+{
+	char	digits[32];
+	int		len;
+
+	if (value == 0)
+		value = 0;
+	len = snprintf(digits, sizeof(digits), "%.15g", value);
+
+	out.append(digits, static_cast<size_t>(len));
+}
+
+// one output line of the batch and column modes: the result or the error
+void	appendRpnResult(std::string& out, RpnStatus status, int result,
+			size_t offset, RpnMode mode)
+{
+	appendRpnResult(out, status, static_cast<long long>(result), offset, mode);
+}
+
+void	appendRpnResult(std::string& out, RpnStatus status, long long result,
+			size_t offset, RpnMode mode)
+{
+	if (status != RPN_OK)
+	{
+		out += "Error: ";
+		appendRpnError(out, status, offset, mode);
+		out += '\n';
+		return ;
+	}
+	appendRpnInteger(out, result);
+	out += '\n';
+}
+
+void	appendRpnResult(std::string& out, RpnStatus status, double result,
+			size_t offset)
+{
+	if (status != RPN_OK)
+	{
+		appendRpnResult(out, status, 0LL, offset, RPN_MODE_FLOAT);
+		return ;
+	}
+	appendRpnReal(out, result);
+	out += '\n';
+}
+
+void	appendRpnResult(std::string& out, const BigInt& result)
+{
+	result.appendTo(out);
+	out += '\n';
+}
+
+
+
+
+
+// --- helper functions definition ---
+// the characters operator>> skips in the C locale
+static bool	isBlank(char c)
+{
+	return (c == ' ' || (c >= '\t' && c <= '\r'));
+}
+
+// A registered token, or a counted one followed by a count of at least 1.
+// Entries are told apart by their first character before any compare, so
+// the four arithmetic operators cost one pass of char tests.
+static const RpnOperator*	findOperator(const char* begin, const char* end,
+								int& count)
+{
+	size_t	size = static_cast<size_t>(end - begin);
+
+	if (size == 0)
+		return (NULL);
+	for (const RpnOperator* op = g_operators; op->token; op++)
+	{
+		if (op->token[0] != *begin)
+			continue;
+
+		size_t	len = std::strlen(op->token);
+
+		if (op->pops && size == len && !std::memcmp(begin, op->token, len))
+		{
+			count = op->pops;
+			return (op);
+		}
+		if (!op->pops && size > len && !std::memcmp(begin, op->token, len)
+			&& std::isdigit(static_cast<unsigned char>(begin[len]))
+			&& parseRpnValue(begin + len, end, count) && count > 0)
+			return (op);
+	}
+	return (NULL);
+}
+
+static bool	isVariableName(const char* begin, const char* end)
+{
+	if (begin == end || !(std::isalpha(static_cast<unsigned char>(*begin))
+		|| *begin == '_'))
+		return (false);
+	for (begin++; begin < end; begin++)
+	{
+		if (!(std::isalnum(static_cast<unsigned char>(*begin)) || *begin == '_'))
+			return (false);
+	}
+	return (true);
+}
+
+// Exponentiation by squaring within [low, high], low = -high - 1. A
+// negative exponent truncates like division: 0 unless the base is 1 or -1.
+// Once the squared base leaves the range so would the result, as no power
+// of two of odd exponent is a square.
+static RpnStatus	powInteger(long long base, long long exponent,
+						long long low, long long high, long long& result)
+{
+	if (exponent < 0)
+	{
+		if (base == 0)
+			return (RPN_DIVISION_BY_ZERO);
+		if (base == 1 || base == -1)
+			result = (base == -1 && (exponent & 1)) ? -1 : 1;
+		else
+			result = 0;
+		return (RPN_OK);
+	}
+	result = 1;
+	while (exponent > 0)
+	{
+		if ((exponent & 1) && (__builtin_mul_overflow(result, base, &result)
+			|| result < low || result > high))
+			return (RPN_RANGE_ERROR);
+		exponent >>= 1;
+		if (exponent > 0 && (__builtin_mul_overflow(base, base, &base)
+			|| base > high))
+			return (RPN_RANGE_ERROR);
+	}
+	return (RPN_OK);
+}
+
+// powInteger() on BigInts, base replaced by the result
+static RpnStatus	powBig(BigInt& base, const BigInt& exponent)
+{
+	long long	small = 0;
+	long long	count;
+	bool		unit = base.toLongLong(small) && small >= -1 && small <= 1;
+
+	if (exponent.sign() < 0)
+	{
+		if (base.isZero())
+			return (RPN_DIVISION_BY_ZERO);
+		base.assign(unit ? ((small == -1 && exponent.isOdd()) ? -1 : 1) : 0);
+		return (RPN_OK);
+	}
+	if (exponent.isZero())
+		base.assign(1);
+	else if (unit)
+		base.assign((small == -1 && !exponent.isOdd()) ? 1 : small);
+	else if (!exponent.toLongLong(count) || count > RPN_BIG_POW_MAX)
+		return (RPN_RANGE_ERROR);
+	else
+		BigInt::pow(base, static_cast<unsigned long>(count), base);
+	return (RPN_OK);
+}
+
+static bool	isFinite(double value)
+{
+	return (value - value == 0);
+}
+
+// FNV-1a over the opcode and both operands, folded to a memo slot
+static size_t	foldSlot(RpnOpcode opcode, int lhs, int rhs)
+{
+	uint64_t		hash = 14695981039346656037ULL;
+	unsigned int	words[3] = {static_cast<unsigned int>(opcode),
+		static_cast<unsigned int>(lhs), static_cast<unsigned int>(rhs)};
+
+	for (size_t i = 0; i < 3; i++)
+	{
+		hash ^= words[i];
+		hash *= 1099511628211ULL;
+	}
+	return (static_cast<size_t>(hash ^ (hash >> 32)) % RPN_FOLD_MEMO);
+}
+
+// Overflow checks without branches or 64-bit lanes: a + b overflows when
+// the result's sign differs from both operands', a - b when a and b differ
+// in sign and the result's sign differs from a's, and a * b when its
+// double product leaves the int range (rounding never brings an out of
+// range product back in). A lane only takes an error while it has none.
+static void	blockAdd(int* __restrict__ a, const int* __restrict__ b,
+				int* __restrict__ lanes)
+{
+	for (int j = 0; j < RPN_BLOCK; j++)
+	{
+		int	sum = static_cast<int>(static_cast<unsigned int>(a[j])
+			+ static_cast<unsigned int>(b[j]));
+		int	bad = ((a[j] ^ sum) & (b[j] ^ sum)) < 0;
+
+		lanes[j] |= -(bad & (lanes[j] == RPN_OK)) & RPN_RANGE_ERROR;
+		a[j] = sum;
+	}
+}
+
+static void	blockSub(int* __restrict__ a, const int* __restrict__ b,
+				int* __restrict__ lanes)
+{
+	for (int j = 0; j < RPN_BLOCK; j++)
+	{
+		int	diff = static_cast<int>(static_cast<unsigned int>(a[j])
+			- static_cast<unsigned int>(b[j]));
+		int	bad = ((a[j] ^ b[j]) & (a[j] ^ diff)) < 0;
+
+		lanes[j] |= -(bad & (lanes[j] == RPN_OK)) & RPN_RANGE_ERROR;
+		a[j] = diff;
+	}
+}
+
+static void	blockMul(int* __restrict__ a, const int* __restrict__ b,
+				int* __restrict__ lanes)
+{
+	for (int j = 0; j < RPN_BLOCK; j++)
+	{
+		double	exact = static_cast<double>(a[j]) * b[j];
+		int		bad = (exact > INT_MAX) | (exact < INT_MIN);
+
+		lanes[j] |= -(bad & (lanes[j] == RPN_OK)) & RPN_RANGE_ERROR;
+		a[j] = static_cast<int>(static_cast<unsigned int>(a[j])
+			* static_cast<unsigned int>(b[j]));
+	}
+}
+
+// a zero divisor is replaced by 1 so the lane can go on; only
+// INT_MIN / -1 leaves the int range
+static void	blockDiv(int* __restrict__ a, const int* __restrict__ b,
+				int* __restrict__ lanes)
+{
+	for (int j = 0; j < RPN_BLOCK; j++)
+	{
+		int			zero = (b[j] == 0);
+		long long	quotient = static_cast<long long>(a[j]) / (zero ? 1 : b[j]);
+		int			error = zero ? RPN_DIVISION_BY_ZERO
+			: (quotient > INT_MAX ? RPN_RANGE_ERROR : RPN_OK);
+
+		lanes[j] |= -(lanes[j] == RPN_OK) & error;
+		a[j] = static_cast<int>(quotient);
+	}
+}
+
+static void	blockMod(int* __restrict__ a, const int* __restrict__ b,
+				int* __restrict__ lanes)
+{
+	for (int j = 0; j < RPN_BLOCK; j++)
+	{
+		int	zero = (b[j] == 0);
+
+		lanes[j] |= -(zero & (lanes[j] == RPN_OK)) & RPN_DIVISION_BY_ZERO;
+		a[j] = static_cast<int>(static_cast<long long>(a[j]) % (zero ? 1 : b[j]));
+	}
+}
+
+// scalar per lane; pow is too rare to be worth vectorizing
+static void	blockPow(int* __restrict__ a, const int* __restrict__ b,
+				int* __restrict__ lanes)
+{
+	for (int j = 0; j < RPN_BLOCK; j++)
+	{
+		long long	result = 0;
+		int			error = powInteger(a[j], b[j], INT_MIN, INT_MAX, result);
+
+		lanes[j] |= -(lanes[j] == RPN_OK) & error;
+		a[j] = error ? 0 : static_cast<int>(result);
+	}
+}
+
+static void	blockMin(int* __restrict__ a, const int* __restrict__ b)
+{
+	for (int j = 0; j < RPN_BLOCK; j++)
+		a[j] = std::min(a[j], b[j]);
+}
+
+static void	blockMax(int* __restrict__ a, const int* __restrict__ b)
+{
+	for (int j = 0; j < RPN_BLOCK; j++)
+		a[j] = std::max(a[j], b[j]);
+}
+
+static void	blockNeg(int* __restrict__ a, int* __restrict__ lanes)
+{
+	for (int j = 0; j < RPN_BLOCK; j++)
+	{
+		int	bad = (a[j] == INT_MIN);
+
+		lanes[j] |= -(bad & (lanes[j] == RPN_OK)) & RPN_RANGE_ERROR;
+		a[j] = static_cast<int>(0u - static_cast<unsigned int>(a[j]));
+	}
+}
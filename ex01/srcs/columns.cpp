@@ -0,0 +1,142 @@
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+#include <vector>
+
+#include "colors.hpp"
+#include "columns.hpp"
+#include "dictionary.hpp"
+#include "RpnProgram.class.hpp"
+
+// --- helper functions declaration ---
+static bool			loadColumns(std::ifstream& file,
+						std::vector<std::string>& names,
+						std::vector<std::vector<int> >& columns, size_t& rows);
+static std::string	trimCell(const std::string& line, size_t begin, size_t end);
+static int			columnError(const std::string& what);
+static bool			lineError(const char* what, size_t line_no);
+
+// --- main function ---
+// Evaluates a template such as "a b * c +" over a CSV file whose header
+// names the columns ("a,b,c") and whose rows hold ints; writes one line
+// per row, the result or the row's error, in row order.
+int	RPNColumns(const char* path, const std::string& expression)
+{
+	std::ifstream					file(path);
+	std::vector<std::string>		names;
+	std::vector<std::vector<int> >	columns;
+	size_t							rows = 0;
+
+	if (!file)
+		return (columnError(std::string("could not read \"") + path + "\"."));
+	if (!loadColumns(file, names, columns, rows))
+		return (ERROR);
+
+	RpnProgram	program;
+	program.compileTemplate(expression.data(),
+		expression.data() + expression.size());
+
+	const std::vector<std::string>&	variables = program.variables();
+	std::vector<const int*>			bound(variables.size() + 1);
+	for (size_t i = 0; i < variables.size(); i++)
+	{
+		size_t	column = 0;
+
+		while (column < names.size() && names[column] != variables[i])
+			column++;
+		if (column == names.size())
+			return (columnError("unknown variable \"" + variables[i] + "\"."));
+		bound[i] = columns[column].empty() ? NULL : &columns[column][0];
+	}
+
+	std::vector<int>			workspace(program.workspaceSize());
+	std::vector<int>			results(rows + 1);
+	std::vector<unsigned char>	status(rows + 1);
+	program.runColumns(&bound[0], rows, &results[0], &status[0], &workspace[0]);
+
+	std::string	out;
+	for (size_t i = 0; i < rows; i++)
+		appendRpnResult(out, static_cast<RpnStatus>(status[i]), results[i],
+			program.errorOffset());
+	std::cout << out << std::flush;
+
+	return (OK);
+}
+
+
+
+
+
+// --- helper functions definition ---
+static bool	loadColumns(std::ifstream& file, std::vector<std::string>& names,
+				std::vector<std::vector<int> >& columns, size_t& rows)
+{
+	std::string	line;
+
+	if (!std::getline(file, line))
+		return (lineError("missing header on line", 1));
+	for (size_t begin = 0; begin <= line.size(); )
+	{
+		size_t	comma = line.find(',', begin);
+
+		if (comma == std::string::npos)
+			comma = line.size();
+		names.push_back(trimCell(line, begin, comma));
+		begin = comma + 1;
+	}
+	columns.resize(names.size());
+
+	size_t	line_no = 1;
+	while (std::getline(file, line))
+	{
+		size_t	column = 0;
+		size_t	begin = 0;
+
+		line_no++;
+		if (trimCell(line, 0, line.size()).empty())
+			continue;
+		for (; column < names.size() && begin <= line.size(); column++)
+		{
+			size_t		comma = line.find(',', begin);
+			std::string	cell;
+			int			value;
+
+			if (comma == std::string::npos)
+				comma = line.size();
+			cell = trimCell(line, begin, comma);
+			if (!parseRpnValue(cell.data(), cell.data() + cell.size(), value))
+				return (lineError("bad cell on line", line_no));
+			columns[column].push_back(value);
+			begin = comma + 1;
+		}
+		if (column != names.size() || begin <= line.size())
+			return (lineError("wrong number of cells on line", line_no));
+		rows++;
+	}
+	return (true);
+}
+
+static std::string	trimCell(const std::string& line, size_t begin, size_t end)
+{
+	while (begin < end && std::isspace(static_cast<unsigned char>(line[begin])))
+		begin++;
+	while (end > begin && std::isspace(static_cast<unsigned char>(line[end - 1])))
+		end--;
+	return (line.substr(begin, end - begin));
+}
+
+static int	columnError(const std::string& what)
+{
+	std::cerr << RED "Error:" RESET << " " << what << std::endl;
+
+	return (ERROR);
+}
+
+static bool	lineError(const char* what, size_t line_no)
+{
+	std::cerr << RED "Error:" RESET << " " << what << " " << line_no << "."
+		<< std::endl;
+
+	return (false);
+}
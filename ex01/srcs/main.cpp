@@ -1,12 +1,23 @@
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
 #include <iostream>
 #include <sstream>
+#include <unistd.h>
 
 #include "colors.hpp"
 #include "dictionary.hpp"
+#include "columns.hpp"
 #include "RPN.hpp"
+#include "RpnBatch.class.hpp"
 
 // --- helper functions declaration ---
+static bool	parseModeFlag(const char* arg, RpnMode& mode, bool& bignum);
+static bool	parseSize(const char* arg, size_t& size);
+static int	runBatch(int ac, char** av);
 static int	badUsage();
+static int	badFile(const char* path);
+static int	badOutput();
 
 // --- main function ---
 int main(int ac, char** av)
@@ -16,17 +27,32 @@ int main(int ac, char** av)
 		badUsage();
 		return (NOK);
 	}
+	if (!std::strcmp(av[1], "--batch"))
+		return (runBatch(ac, av));
+	if (!std::strcmp(av[1], "--columns"))
+	{
+		if (ac != 4)
+			return (badUsage());
+		return (RPNColumns(av[2], av[3]) == ERROR ? NOK : OK);
+	}
 
+	RpnMode		mode = RPN_MODE_INT;
+	bool		bignum = false;
+	int			first = 1;
 	std::string expression;
 
-	if (ac == 2)
+	while (first < ac && parseModeFlag(av[first], mode, bignum))
+		first++;
+	if (first == ac || (bignum && mode == RPN_MODE_FLOAT))
+		return (badUsage());
+	if (ac == first + 1)
 	{
-		expression = av[1];
+		expression = av[first];
 	}
 	else
 	{
 		std::ostringstream oss;
-		for (int i = 1; i < ac; i++)
+		for (int i = first; i < ac; i++)
 		{
 			oss << av[i];
 			if (i + 1 < ac)
@@ -35,7 +61,7 @@ int main(int ac, char** av)
 		expression = oss.str();
 	}
 
-	if (RPN(expression) == ERROR)
+	if (RPN(expression, mode, bignum) == ERROR)
 		return (NOK);
 
 	return (OK);
@@ -46,11 +72,125 @@ int main(int ac, char** av)
 
 
 // --- helper functions definition ---
+// --i64 and --float pick the number type, --bignum the promotion on
+// overflow; false when arg is none of them
+static bool	parseModeFlag(const char* arg, RpnMode& mode, bool& bignum)
+{
+	if (!std::strcmp(arg, "--i64"))
+		mode = RPN_MODE_I64;
+	else if (!std::strcmp(arg, "--float"))
+		mode = RPN_MODE_FLOAT;
+	else if (!std::strcmp(arg, "--bignum"))
+		bignum = true;
+	else
+		return (false);
+	return (true);
+}
+
+// a byte count, optionally followed by K, M or G
+static bool	parseSize(const char* arg, size_t& size)
+{
+	char*	end;
+
+	size = std::strtoul(arg, &end, 10);
+	if (end == arg || *arg == '-')
+		return (false);
+	if (*end == 'K')
+		size <<= 10;
+	else if (*end == 'M')
+		size <<= 20;
+	else if (*end == 'G')
+		size <<= 30;
+	else
+		return (*end == '\0');
+	return (end[1] == '\0');
+}
+
+// ./RPN --batch [--threads N] [--cache SIZE] [flags] [FILE | -]: one
+// expression per line; with a cache, its counters go to stderr at the end
+static int	runBatch(int ac, char** av)
+{
+	const char*	path = NULL;
+	size_t		threads = 1;
+	size_t		cache = 0;
+	RpnMode		mode = RPN_MODE_INT;
+	bool		bignum = false;
+
+	for (int i = 2; i < ac; i++)
+	{
+		if (!std::strcmp(av[i], "--threads") && i + 1 < ac)
+		{
+			char*	end;
+
+			threads = std::strtoul(av[++i], &end, 10);
+			if (*end != '\0' || *av[i] == '-' || threads < 1 || threads > THREADS_MAX)
+				return (badUsage());
+		}
+		else if (!std::strcmp(av[i], "--cache") && i + 1 < ac)
+		{
+			if (!parseSize(av[++i], cache) || cache == 0)
+				return (badUsage());
+		}
+		else if (parseModeFlag(av[i], mode, bignum))
+			continue;
+		else if (path || (!std::strncmp(av[i], "--", 2) && av[i][2] != '\0'))
+			return (badUsage());
+		else
+			path = av[i];
+	}
+
+	if (bignum && mode == RPN_MODE_FLOAT)
+		return (badUsage());
+
+	int	fd = STDIN_FILENO;
+	if (path && std::strcmp(path, "-"))
+		fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return (badFile(path));
+
+	RpnBatch	batch(fd, STDOUT_FILENO, threads, mode, bignum, cache);
+	int			status = batch.run();
+
+	if (fd != STDIN_FILENO)
+		close(fd);
+	if (cache)
+	{
+		std::cerr << YELLOW "Cache:" RESET << " " << batch.cacheHits()
+			<< " hits, " << batch.cacheMisses() << " misses, "
+			<< batch.cacheEvictions() << " evictions." << std::endl;
+	}
+	if (status == ERROR && batch.writeFailed())
+		return (badOutput());
+	if (status == ERROR)
+		return (badFile(path ? path : "-"));
+	return (OK);
+}
+
 static int	badUsage()
 {
 	std::cerr << RED "Error:" RESET << " bad usage => ";
-	std::cerr << "./RPN \"<RPN expression>\"" << std::endl;
+	std::cerr << "./RPN [flags] \"<RPN expression>\"" << std::endl;
+	std::cerr << "       ./RPN --batch [--threads N] [--cache SIZE[K|M|G]] [flags]"
+		" [FILE | -]" << std::endl;
+	std::cerr << "       ./RPN --columns FILE \"<RPN template>\"" << std::endl;
+	std::cerr << "       flags: --i64 | --float, --bignum (not with --float)" << std::endl;
+	std::cerr << "       operators: + - * / % pow min max neg dup swap drop sumN"
+		<< std::endl;
 	std::cerr << YELLOW "Example: " RESET << "./RPN \"3 4 5 * +\"" << std::endl;
 
 	return (NOK);
 }
+
+static int	badFile(const char* path)
+{
+	std::cerr << RED "Error:" RESET << " could not read \"" << path << "\"." << std::endl;
+
+	return (NOK);
+}
+
+static int	badOutput()
+{
+	std::cerr << RED "Error:" RESET << " could not write output." << std::endl;
+
+	return (NOK);
+}